@@ -20,6 +20,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "pair_sw.h"
+#include "pair_sw_sort.h"
+#include "pair_sw_kernel.h"
 #include "atom.h"
 #include "neighbor.h"
 #include "neigh_request.h"
@@ -30,8 +32,10 @@
 #include "neigh_list.h"
 #include "memory.h"
 #include "error.h"
+#include "suffix.h"
 
 using namespace LAMMPS_NS;
+using namespace PairSWSort;
 
 #define MAXLINE 1024
 #define DELTA 4
@@ -54,6 +58,20 @@ PairSW::PairSW(LAMMPS *lmp) : Pair(lmp)
 
   maxshort = 10;
   neighshort = NULL;
+  shortrsq = sortrsq = NULL;
+  shortelem = shortend = sortneigh = shortfirst = NULL;
+  sortflag = NONE;
+  tripflag = 0;
+  schedflag = SCHED_COST;
+  ownerflag = 0;
+  ntrip = maxtrip = nleg = maxleg = 0;
+  trip = NULL;
+  leg = NULL;
+  legbuf = NULL;
+  legmap = NULL;
+  tripbuild = -1;
+  maxwork = 0;
+  atomwork = NULL;
 }
 
 /* ----------------------------------------------------------------------
@@ -69,11 +87,22 @@ PairSW::~PairSW()
   delete [] elements;
   memory->destroy(params);
   memory->destroy(elem2param);
+  memory->destroy(shortfirst);
+  memory->sfree(trip);
+  memory->sfree(leg);
+  memory->destroy(legbuf);
+  memory->destroy(atomwork);
 
   if (allocated) {
     memory->destroy(setflag);
     memory->destroy(cutsq);
     memory->destroy(neighshort);
+    memory->destroy(shortrsq);
+    memory->destroy(shortelem);
+    memory->destroy(shortend);
+    memory->destroy(sortneigh);
+    memory->destroy(sortrsq);
+    memory->destroy(legmap);
     delete [] map;
   }
 }
@@ -82,7 +111,7 @@ PairSW::~PairSW()
 
 void PairSW::compute(int eflag, int vflag)
 {
-  int i,j,k,ii,jj,kk,inum,jnum,jnumm1;
+  int i,j,k,ii,jj,kk,krun,kend,inum,jnum,jnumm1;
   int itype,jtype,ktype,ijparam,ikparam,ijkparam;
   tagint itag,jtag;
   double xtmp,ytmp,ztmp,delx,dely,delz,evdwl,fpair;
@@ -106,6 +135,16 @@ void PairSW::compute(int eflag, int vflag)
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
 
+  // work counts of local atoms are those of the current step
+
+  if (atom->nmax > maxwork) {
+    memory->destroy(atomwork);
+    maxwork = atom->nmax;
+    memory->create(atomwork,maxwork,NWORK,"pair:atomwork");
+  }
+  for (i = 0; i < nlocal; i++)
+    atomwork[i][WNEIGH] = atomwork[i][WTRIP] = atomwork[i][WSOFT] = 0.0;
+
   double fxtmp,fytmp,fztmp;
 
   // loop over full neighbor list of my atoms
@@ -139,10 +178,12 @@ void PairSW::compute(int eflag, int vflag)
       if (rsq >= params[ijparam].cutsq) {
         continue;
       } else {
+        shortrsq[numshort] = rsq;
+        shortelem[numshort] = jtype;
         neighshort[numshort++] = j;
         if (numshort >= maxshort) {
           maxshort += maxshort/2;
-          memory->grow(neighshort,maxshort,"pair:neighshort");
+          grow_short();
         }
       }
 
@@ -170,45 +211,64 @@ void PairSW::compute(int eflag, int vflag)
                            evdwl,0.0,fpair,delx,dely,delz);
     }
 
-    jnumm1 = numshort - 1;
+    // optionally group the short neighbors by element, then walk the
+    // k partners in runs of one element with their parameters hoisted.
+    // with a cached triplet list the three-body terms are done below
+
+    // every pair of short neighbors is a triplet
+
+    atomwork[i][WNEIGH] = jnum + 0.5*numshort*(numshort-1);
+    if (!tripflag) atomwork[i][WTRIP] = 0.5*numshort*(numshort-1);
+
+    jnumm1 = tripflag ? 0 : numshort - 1;
+
+    if (jnumm1 > 0) {
+      if (sortflag != NONE)
+        sort_short(numshort,nelements,sortflag,neighshort,shortrsq,shortelem,
+                   shortfirst,sortneigh,sortrsq);
+      short_runs(numshort,shortelem,shortend);
+    }
 
     for (jj = 0; jj < jnumm1; jj++) {
       j = neighshort[jj];
-      jtype = map[type[j]];
+      jtype = shortelem[jj];
       ijparam = elem2param[itype][jtype][jtype];
       delr1[0] = x[j][0] - xtmp;
       delr1[1] = x[j][1] - ytmp;
       delr1[2] = x[j][2] - ztmp;
-      rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+      rsq1 = shortrsq[jj];
 
       double fjxtmp,fjytmp,fjztmp;
       fjxtmp = fjytmp = fjztmp = 0.0;
 
-      for (kk = jj+1; kk < numshort; kk++) {
-        k = neighshort[kk];
-        ktype = map[type[k]];
+      for (kk = jj+1; kk < numshort; kk = kend) {
+        kend = shortend[kk];
+        ktype = shortelem[kk];
         ikparam = elem2param[itype][ktype][ktype];
         ijkparam = elem2param[itype][jtype][ktype];
 
-        delr2[0] = x[k][0] - xtmp;
-        delr2[1] = x[k][1] - ytmp;
-        delr2[2] = x[k][2] - ztmp;
-        rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
-
-        threebody(&params[ijparam],&params[ikparam],&params[ijkparam],
-                  rsq1,rsq2,delr1,delr2,fj,fk,eflag,evdwl);
-
-        fxtmp -= fj[0] + fk[0];
-        fytmp -= fj[1] + fk[1];
-        fztmp -= fj[2] + fk[2];
-        fjxtmp += fj[0];
-        fjytmp += fj[1];
-        fjztmp += fj[2];
-        f[k][0] += fk[0];
-        f[k][1] += fk[1];
-        f[k][2] += fk[2];
-
-        if (evflag) ev_tally3(i,j,k,evdwl,0.0,fj,fk,delr1,delr2);
+        for (krun = kk; krun < kend; krun++) {
+          k = neighshort[krun];
+          delr2[0] = x[k][0] - xtmp;
+          delr2[1] = x[k][1] - ytmp;
+          delr2[2] = x[k][2] - ztmp;
+          rsq2 = shortrsq[krun];
+
+          threebody(&params[ijparam],&params[ikparam],&params[ijkparam],
+                    rsq1,rsq2,delr1,delr2,fj,fk,eflag,evdwl);
+
+          fxtmp -= fj[0] + fk[0];
+          fytmp -= fj[1] + fk[1];
+          fztmp -= fj[2] + fk[2];
+          fjxtmp += fj[0];
+          fjytmp += fj[1];
+          fjztmp += fj[2];
+          f[k][0] += fk[0];
+          f[k][1] += fk[1];
+          f[k][2] += fk[2];
+
+          if (evflag) ev_tally3(i,j,k,evdwl,0.0,fj,fk,delr1,delr2);
+        }
       }
       f[j][0] += fjxtmp;
       f[j][1] += fjytmp;
@@ -219,6 +279,11 @@ void PairSW::compute(int eflag, int vflag)
     f[i][2] += fztmp;
   }
 
+  if (tripflag) {
+    if (tripbuild != neighbor->ncalls) build_triplets(this);
+    eval_triplets(this,eflag);
+  }
+
   if (vflag_fdotr) virial_fdotr_compute();
 }
 
@@ -231,17 +296,83 @@ void PairSW::allocate()
 
   memory->create(setflag,n+1,n+1,"pair:setflag");
   memory->create(cutsq,n+1,n+1,"pair:cutsq");
-  memory->create(neighshort,maxshort,"pair:neighshort");
+  grow_short();
   map = new int[n+1];
 }
 
+/* ----------------------------------------------------------------------
+   (re)allocate the short neighbor list and its per neighbor data
+------------------------------------------------------------------------- */
+
+void PairSW::grow_short()
+{
+  memory->grow(neighshort,maxshort,"pair:neighshort");
+  memory->grow(shortrsq,maxshort,"pair:shortrsq");
+  memory->grow(shortelem,maxshort,"pair:shortelem");
+  memory->grow(shortend,maxshort,"pair:shortend");
+  memory->grow(sortneigh,maxshort,"pair:sortneigh");
+  memory->grow(sortrsq,maxshort,"pair:sortrsq");
+  memory->destroy(legmap);
+  memory->create(legmap,2*maxshort*nelements,"pair:legmap");
+}
+
 /* ----------------------------------------------------------------------
    global settings
 ------------------------------------------------------------------------- */
 
 void PairSW::settings(int narg, char **arg)
 {
-  if (narg != 0) error->all(FLERR,"Illegal pair_style command");
+  // optional keyword:
+  // sort none/element/distance = order of the short neighbor list
+  //   used by the three-body loop, see pair_sw_sort.h
+  // triplets yes/no = cache the candidate triplets at reneighboring
+  //   and evaluate the three-body terms in one flat loop over them
+  // schedule even/cost = division of the atoms among threads in the
+  //   /omp variant, equal counts or equal estimated cost
+  // owner yes/no = in the /omp variant each thread computes the complete
+  //   force on its own atoms and writes no other atom, see pair_sw_omp.cpp
+
+  sortflag = NONE;
+  tripflag = 0;
+  tripbuild = -1;
+  schedflag = SCHED_COST;
+  ownerflag = 0;
+
+  int iarg = 0;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg],"sort") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"none") == 0) sortflag = NONE;
+      else if (strcmp(arg[iarg+1],"element") == 0) sortflag = ELEMENT;
+      else if (strcmp(arg[iarg+1],"distance") == 0) sortflag = DISTANCE;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"triplets") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"yes") == 0) tripflag = 1;
+      else if (strcmp(arg[iarg+1],"no") == 0) tripflag = 0;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"schedule") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (!(suffix_flag & Suffix::OMP))
+        error->all(FLERR,"Pair style sw keywords schedule and owner "
+                   "require pair style sw/omp");
+      if (strcmp(arg[iarg+1],"even") == 0) schedflag = SCHED_EVEN;
+      else if (strcmp(arg[iarg+1],"cost") == 0) schedflag = SCHED_COST;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"owner") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (!(suffix_flag & Suffix::OMP))
+        error->all(FLERR,"Pair style sw keywords schedule and owner "
+                   "require pair style sw/omp");
+      if (strcmp(arg[iarg+1],"yes") == 0) ownerflag = 1;
+      else if (strcmp(arg[iarg+1],"no") == 0) ownerflag = 0;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else error->all(FLERR,"Illegal pair_style command");
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -486,6 +617,9 @@ void PairSW::setup_params()
 
   memory->destroy(elem2param);
   memory->create(elem2param,nelements,nelements,nelements,"pair:elem2param");
+  memory->destroy(shortfirst);
+  memory->create(shortfirst,nelements+1,"pair:shortfirst");
+  grow_short();
 
   for (i = 0; i < nelements; i++)
     for (j = 0; j < nelements; j++)
@@ -555,18 +689,7 @@ void PairSW::setup_params()
 void PairSW::twobody(Param *param, double rsq, double &fforce,
                      int eflag, double &eng)
 {
-  double r,rinvsq,rp,rq,rainv,rainvsq,expsrainv;
-
-  r = sqrt(rsq);
-  rinvsq = 1.0/rsq;
-  rp = pow(r,-param->powerp);
-  rq = pow(r,-param->powerq);
-  rainv = 1.0 / (r - param->cut);
-  rainvsq = rainv*rainv*r;
-  expsrainv = exp(param->sigma * rainv);
-  fforce = (param->c1*rp - param->c2*rq +
-            (param->c3*rp -param->c4*rq) * rainvsq) * expsrainv * rinvsq;
-  if (eflag) eng = (param->c5*rp - param->c6*rq) * expsrainv;
+  PairSWKernel::twobody(param,param->cut,rsq,fforce,eflag,eng);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -576,52 +699,45 @@ void PairSW::threebody(Param *paramij, Param *paramik, Param *paramijk,
                        double *delr1, double *delr2,
                        double *fj, double *fk, int eflag, double &eng)
 {
-  double r1,rinvsq1,rainv1,gsrainv1,gsrainvsq1,expgsrainv1;
-  double r2,rinvsq2,rainv2,gsrainv2,gsrainvsq2,expgsrainv2;
-  double rinv12,cs,delcs,delcssq,facexp,facrad,frad1,frad2;
-  double facang,facang12,csfacang,csfac1,csfac2;
-
-  r1 = sqrt(rsq1);
-  rinvsq1 = 1.0/rsq1;
-  rainv1 = 1.0/(r1 - paramij->cut);
-  gsrainv1 = paramij->sigma_gamma * rainv1;
-  gsrainvsq1 = gsrainv1*rainv1/r1;
-  expgsrainv1 = exp(gsrainv1);
-
-  r2 = sqrt(rsq2);
-  rinvsq2 = 1.0/rsq2;
-  rainv2 = 1.0/(r2 - paramik->cut);
-  gsrainv2 = paramik->sigma_gamma * rainv2;
-  gsrainvsq2 = gsrainv2*rainv2/r2;
-  expgsrainv2 = exp(gsrainv2);
-
-  rinv12 = 1.0/(r1*r2);
-  cs = (delr1[0]*delr2[0] + delr1[1]*delr2[1] + delr1[2]*delr2[2]) * rinv12;
-  delcs = cs - paramijk->costheta;
-  delcssq = delcs*delcs;
-
-  facexp = expgsrainv1*expgsrainv2;
-
-  // facrad = sqrt(paramij->lambda_epsilon*paramik->lambda_epsilon) *
-  //          facexp*delcssq;
-
-  facrad = paramijk->lambda_epsilon * facexp*delcssq;
-  frad1 = facrad*gsrainvsq1;
-  frad2 = facrad*gsrainvsq2;
-  facang = paramijk->lambda_epsilon2 * facexp*delcs;
-  facang12 = rinv12*facang;
-  csfacang = cs*facang;
-  csfac1 = rinvsq1*csfacang;
-
-  fj[0] = delr1[0]*(frad1+csfac1)-delr2[0]*facang12;
-  fj[1] = delr1[1]*(frad1+csfac1)-delr2[1]*facang12;
-  fj[2] = delr1[2]*(frad1+csfac1)-delr2[2]*facang12;
-
-  csfac2 = rinvsq2*csfacang;
-
-  fk[0] = delr2[0]*(frad2+csfac2)-delr1[0]*facang12;
-  fk[1] = delr2[1]*(frad2+csfac2)-delr1[1]*facang12;
-  fk[2] = delr2[2]*(frad2+csfac2)-delr1[2]*facang12;
-
-  if (eflag) eng = facrad;
+  double expgsrainv1,dexpgsrainv1,expgsrainv2,dexpgsrainv2;
+
+  PairSWKernel::exp_radial(sqrt(rsq1),paramij->cut,paramij->sigma_gamma,
+                           expgsrainv1,dexpgsrainv1);
+  PairSWKernel::exp_radial(sqrt(rsq2),paramik->cut,paramik->sigma_gamma,
+                           expgsrainv2,dexpgsrainv2);
+  threebody(paramijk,rsq1,rsq2,delr1,delr2,expgsrainv1,dexpgsrainv1,
+            expgsrainv2,dexpgsrainv2,fj,fk,eflag,eng);
+}
+
+/* ----------------------------------------------------------------------
+   three-body term of set paramijk with the radial factors of both legs
+   given, e.g. from the legs of the cached triplets
+------------------------------------------------------------------------- */
+
+void PairSW::threebody(Param *paramijk, double rsq1, double rsq2,
+                       double *delr1, double *delr2,
+                       double expgsrainv1, double dexpgsrainv1,
+                       double expgsrainv2, double dexpgsrainv2,
+                       double *fj, double *fk, int eflag, double &eng)
+{
+  PairSWKernel::threebody<0>(paramijk->lambda_epsilon,paramijk->lambda_epsilon2,
+                             paramijk->costheta,0.0,rsq1,rsq2,delr1,delr2,
+                             expgsrainv1,dexpgsrainv1,expgsrainv2,dexpgsrainv2,
+                             fj,fk,eflag,eng);
+}
+
+/* ----------------------------------------------------------------------
+   atomwork = per-atom work of the last step for load balancing,
+   nlocal x 3 and not per type like the arrays of other pair styles,
+   one row per local atom with the # of neighbor and neighbor-of-neighbor
+   visits, of evaluated triplets and of softened pairs (none for sw)
+------------------------------------------------------------------------- */
+
+void *PairSW::extract(const char *str, int &dim)
+{
+  if (strcmp(str,"atomwork") == 0) {
+    dim = 2;
+    return (void *) atomwork;
+  }
+  return NULL;
 }
@@ -21,6 +21,8 @@ PairStyle(sw,PairSW)
 #define LMP_PAIR_SW_H
 
 #include "pair.h"
+#include "pair_sw_kernel.h"
+#include "pair_sw_sort.h"
 
 namespace LAMMPS_NS {
 
@@ -34,6 +36,13 @@ class PairSW : public Pair {
   virtual double init_one(int, int);
   virtual void init_style();
 
+  // extract("atomwork") sets dim = 2 and returns the per-atom work
+  // counts as double[nlocal][3]: neighbor visits, triplets and softened
+  // pairs (always 0 here) of the last step. it is reallocated when the
+  // number of atoms grows, so callers fetch it again after each run.
+  // no other name is extracted and dim is left unchanged for them
+  virtual void *extract(const char *, int &);
+
   struct Param {
     double epsilon,sigma;
     double littlea,lambda,gamma,costheta;
@@ -46,6 +55,11 @@ class PairSW : public Pair {
     int ielement,jelement,kelement;
   };
 
+  // cached candidate triplet and the legs it combines
+
+  typedef PairSWSort::Triplet Triplet;
+  typedef PairSWSort::Leg Leg;
+
  protected:
   double cutmax;                // max cutoff for all elements
   int nelements;                // # of unique elements
@@ -57,13 +71,62 @@ class PairSW : public Pair {
   Param *params;                // parameter set for an I-J-K interaction
   int maxshort;                 // size of short neighbor list array
   int *neighshort;              // short neighbor list array
+  double *shortrsq;             // r^2 of short neighbors
+  int *shortelem;               // element of short neighbors
+  int *shortend;                // end of the run of equal elements
+  int *shortfirst;              // first short neighbor of each element
+  int *sortneigh;               // scratch for sorting the short list
+  double *sortrsq;
+  int sortflag;                 // ordering of the short list
+  int tripflag;                 // 1 if triplets are cached between reneighborings
+  int schedflag;                // division of the atoms among threads
+  int ownerflag;                // 1 if threads only write forces of their atoms
+  int ntrip;                    // # of cached triplets
+  int maxtrip;                  // size of triplet list
+  Triplet *trip;                // cached candidate triplets
+  int nleg,maxleg;              // # of legs and size of leg
+  Leg *leg;                     // legs of the cached triplets
+  double **legbuf;              // per step geometry and radial factors of legs
+  int *legmap;                  // scratch to number the legs of one atom
+  bigint tripbuild;             // neighbor list build trip was made for
+  int maxwork;                  // allocated size of atomwork
+  double **atomwork;            // work counts of local atoms, see extract()
 
   virtual void allocate();
+  void grow_short();
   void read_file(char *);
   virtual void setup_params();
   void twobody(Param *, double, double &, int, double &);
   void threebody(Param *, Param *, Param *, double, double, double *, double *,
                  double *, double *, int, double &);
+  void threebody(Param *, double, double, double *, double *,
+                 double, double, double, double,
+                 double *, double *, int, double &);
+
+  // cached triplets of the triplets option, built and evaluated by the
+  // templates in pair_sw_sort.h. the legs of an i-j-k set use the
+  // cutoff and gamma of the i-j-j and i-k-k sets as in threebody()
+
+  template <class PAIR> friend void PairSWSort::build_triplets(PAIR *);
+  template <class PAIR> friend void PairSWSort::eval_triplets(PAIR *, int);
+
+  int legparam(int m, int side) const {
+    const int e = side ? params[m].kelement : params[m].jelement;
+    return elem2param[params[m].ielement][e][e];
+  }
+  double shortcut(int itype, int jtype) const {
+    return params[elem2param[itype][jtype][jtype]].cut;
+  }
+  double legcut(int m, int side) const {
+    return params[legparam(m,side)].cut;
+  }
+  double legcutsq(int m, int side) const {
+    return params[legparam(m,side)].cutsq;
+  }
+  void legradial(int m, int side, double rsq, double &e, double &de) const {
+    const Param &p = params[legparam(m,side)];
+    PairSWKernel::exp_radial(sqrt(rsq),p.cut,p.sigma_gamma,e,de);
+  }
 };
 
 }
@@ -119,4 +182,9 @@ E: Potential file is missing an entry
 
 The potential file does not have a needed entry.
 
+E: Pair style sw keywords schedule and owner require pair style sw/omp
+
+Both keywords control how the atoms are divided among threads, which
+only the OpenMP version of the style does.
+
 */
@@ -0,0 +1,228 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------------
+   interaction kernels shared by the Stillinger-Weber styles sw, sw/woo
+   and sw/wfnho and their /omp variants: the math of one pair, triplet
+   or coordination term. the neighbor loops stay in each style, which
+   also keeps its own run time options (tables, precision, sorting).
+   features that differ between the potentials are template arguments:
+     ALPHA  = 1 for the cubic alpha correction of the angular term (woo)
+     DFORCE = 1 if the derivative of the softening is needed for forces
+   asymmetric ij/ik cutoffs are handled by computing the radial factor
+   of each leg with its own cutoff and gamma before the angular term
+------------------------------------------------------------------------- */
+
+#ifndef LMP_PAIR_SW_KERNEL_H
+#define LMP_PAIR_SW_KERNEL_H
+
+#include "math.h"
+#include "math_const.h"
+
+namespace LAMMPS_NS {
+
+namespace PairSWKernel {
+
+  /* ----------------------------------------------------------------------
+     linear interpolation in r^2 of two functions tabulated on the same grid
+  ------------------------------------------------------------------------- */
+
+  inline void tab_lookup(const double *te, const double *tf,
+                         double rsqlo, double invdelta, double rsq,
+                         double &e, double &f)
+  {
+    const double p = (rsq - rsqlo) * invdelta;
+    const int itab = static_cast<int> (p);
+    const double frac = p - itab;
+    e = te[itab] + frac * (te[itab+1] - te[itab]);
+    f = tf[itab] + frac * (tf[itab+1] - tf[itab]);
+  }
+
+  /* ----------------------------------------------------------------------
+     cubic Hermite interpolation at p in units of the grid spacing h of a
+     function tabulated as pairs f, h*df at the nodes. dfdp = derivative
+     of the interpolant, so values and derivatives stay consistent
+  ------------------------------------------------------------------------- */
+
+  inline double hermite_lookup(const double *tab, double p, double &dfdp)
+  {
+    const int n = static_cast<int> (p);
+    const double s = p - n;
+    const double *t = tab + 2*n;
+    const double s1 = 1.0 - s;
+    dfdp = 6.0 * s * s1 * (t[2] - t[0]) + s1 * (1.0 - 3.0*s) * t[1] +
+      s * (3.0*s - 2.0) * t[3];
+    return t[0] + s * (t[1] + s * (3.0 * (t[2] - t[0]) - 2.0*t[1] - t[3] +
+                                   s * (2.0 * (t[0] - t[2]) + t[1] + t[3])));
+  }
+
+  /* ----------------------------------------------------------------------
+     two-body energy and force / r at r^2 = rsq with cutoff cut,
+     for any parameter set with the SW fields sigma, powerp, powerq, c1-c6
+  ------------------------------------------------------------------------- */
+
+  template <class P>
+  inline void twobody(const P *param, double cut, double rsq,
+                      double &fforce, int eflag, double &eng)
+  {
+    double r, rinvsq, rp, rq, rainv, rainvsq, expsrainv;
+
+    r = sqrt(rsq);
+    rinvsq = 1.0 / rsq;
+    rp = pow(r, -param->powerp);
+    rq = pow(r, -param->powerq);
+    rainv = 1.0 / (r - cut);
+    rainvsq = rainv * rainv * r;
+    expsrainv = exp(param->sigma * rainv);
+    fforce = (param->c1 * rp - param->c2 * rq +
+              (param->c3 * rp - param->c4 * rq) * rainvsq) * expsrainv * rinvsq;
+    if (eflag) eng = (param->c5 * rp - param->c6 * rq) * expsrainv;
+  }
+
+  /* ----------------------------------------------------------------------
+     three-body radial factor exp(sigma*gamma/(r-a)) and its derivative
+     term exp(sigma*gamma/(r-a)) * sigma*gamma/(r-a)^2/r
+  ------------------------------------------------------------------------- */
+
+  inline void exp_radial(double r, double cut, double sigma_gamma,
+                         double &expgsrainv, double &dexpgsrainv)
+  {
+    const double rainv = 1.0 / (r - cut);
+    const double gsrainv = sigma_gamma * rainv;
+    expgsrainv = exp(gsrainv);
+    dexpgsrainv = expgsrainv * gsrainv * rainv / r;
+  }
+
+  /* ----------------------------------------------------------------------
+     fill a table of ntable intervals in r^2 from lo with spacing delta
+     of exp_radial() and update errmax, the max error beyond r^2 = rsqmin
+     relative to |e| + r^2*|f| plus tabfloor times its largest value
+  ------------------------------------------------------------------------- */
+
+  inline void tabulate_radial(int ntable, double tabfloor,
+                              double *te, double *tf, double lo, double delta,
+                              double rsqmin, double cut, double sigma_gamma,
+                              double &errmax)
+  {
+    int n;
+    double rsq, e, f, et, ft, scale, smax, err;
+
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + n * delta;
+      exp_radial(sqrt(rsq), cut, sigma_gamma, te[n], tf[n]);
+    }
+    te[ntable] = te[ntable+1] = 0.0;
+    tf[ntable] = tf[ntable+1] = 0.0;
+
+    smax = 0.0;
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + n * delta;
+      if (rsq < rsqmin) continue;
+      scale = fabs(te[n]) + rsq * fabs(tf[n]);
+      if (scale > smax) smax = scale;
+    }
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + (n + 0.5) * delta;
+      if (rsq < rsqmin) continue;
+      exp_radial(sqrt(rsq), cut, sigma_gamma, e, f);
+      tab_lookup(te, tf, lo, 1.0/delta, rsq, et, ft);
+      scale = fabs(e) + rsq * fabs(f) + tabfloor * smax;
+      if ((err = fabs(et - e) / scale) > errmax) errmax = err;
+      if ((err = rsq * fabs(ft - f) / scale) > errmax) errmax = err;
+    }
+  }
+
+  /* ----------------------------------------------------------------------
+     three-body term of legs delr1, delr2 with the radial factors of both
+     legs given. lambda_epsilon2 = 2*lambda_epsilon, alpha is only read
+     with ALPHA = 1. fj, fk = forces on the ends of the legs
+  ------------------------------------------------------------------------- */
+
+  template <int ALPHA>
+  inline void threebody(double lambda_epsilon, double lambda_epsilon2,
+                        double costheta, double alpha,
+                        double rsq1, double rsq2,
+                        const double *delr1, const double *delr2,
+                        double expgsrainv1, double dexpgsrainv1,
+                        double expgsrainv2, double dexpgsrainv2,
+                        double *fj, double *fk, int eflag, double &eng)
+  {
+    double rinvsq1, rinvsq2;
+    double rinv12, cs, delcs, delcssq, facexp, facrad, frad1, frad2;
+    double facang, facang12, csfacang, csfac1, csfac2;
+
+    rinvsq1 = 1.0 / rsq1;
+    rinvsq2 = 1.0 / rsq2;
+    rinv12 = 1.0 / sqrt(rsq1 * rsq2);
+    cs = (delr1[0]*delr2[0] + delr1[1]*delr2[1] + delr1[2]*delr2[2]) * rinv12;
+    delcs = cs - costheta;
+    if (ALPHA) delcssq = delcs * delcs * (1.0 + alpha * delcs);
+    else delcssq = delcs * delcs;
+
+    facexp = expgsrainv1 * expgsrainv2;
+
+    facrad = lambda_epsilon * facexp * delcssq;
+    frad1 = lambda_epsilon * delcssq * dexpgsrainv1 * expgsrainv2;
+    frad2 = lambda_epsilon * delcssq * expgsrainv1 * dexpgsrainv2;
+    if (ALPHA) facang = lambda_epsilon * facexp * delcs * (2.0 + 3.0 * alpha * delcs);
+    else facang = lambda_epsilon2 * facexp * delcs;
+    facang12 = rinv12 * facang;
+    csfacang = cs * facang;
+    csfac1 = rinvsq1 * csfacang;
+
+    fj[0] = delr1[0] * (frad1 + csfac1) - delr2[0] * facang12;
+    fj[1] = delr1[1] * (frad1 + csfac1) - delr2[1] * facang12;
+    fj[2] = delr1[2] * (frad1 + csfac1) - delr2[2] * facang12;
+
+    csfac2 = rinvsq2 * csfacang;
+
+    fk[0] = delr2[0] * (frad2 + csfac2) - delr1[0] * facang12;
+    fk[1] = delr2[1] * (frad2 + csfac2) - delr1[1] * facang12;
+    fk[2] = delr2[2] * (frad2 + csfac2) - delr1[2] * facang12;
+
+    if (eflag) eng = facrad;
+  }
+
+  /* ----------------------------------------------------------------------
+     contribution of a neighbor in the transition zone to the coordination
+     number, r = distance / sigma - (R-D) in [0,2D), pibigd = pi/D and
+     inv2bigd = 1/(2D). with DFORCE = 1 also dfc = d(contribution)/dr
+  ------------------------------------------------------------------------- */
+
+  template <int DFORCE>
+  inline double soft_fc(double r, double pibigd, double inv2bigd, double &dfc)
+  {
+    if (DFORCE) dfc = (cos(pibigd * r) - 1.0) * inv2bigd;
+    return 1.0 - r * inv2bigd + sin(pibigd * r) * (1.0/MathConst::MY_2PI);
+  }
+
+  /* ----------------------------------------------------------------------
+     bond softening g(Z) = ma / (exp((mb-Z)/mc) + 1) * exp(md*(Z-me)^2)
+     of coordination number cn, with DFORCE = 1 also dg = dg/dZ
+  ------------------------------------------------------------------------- */
+
+  template <int DFORCE>
+  inline double gsoft(double cn, double ma, double mb, double mcinv,
+                      double md, double me, double &dg)
+  {
+    const double e = exp((mb - cn) * mcinv);
+    const double g = ma / (e + 1.0) * exp(md * (cn - me) * (cn - me));
+    if (DFORCE) dg = g * (2.0 * md * (cn - me) + mcinv / (1.0 + 1.0/e));
+    return g;
+  }
+
+}
+
+}
+
+#endif
@@ -16,13 +16,17 @@
 #include "pair_sw_omp.h"
 #include "atom.h"
 #include "comm.h"
+#include "error.h"
 #include "force.h"
 #include "memory.h"
 #include "neighbor.h"
 #include "neigh_list.h"
+#include "neigh_request.h"
+#include "pair_sw_sort.h"
 
 #include "suffix.h"
 using namespace LAMMPS_NS;
+using namespace PairSWSort;
 
 /* ---------------------------------------------------------------------- */
 
@@ -31,6 +35,60 @@ PairSWOMP::PairSWOMP(LAMMPS *lmp) :
 {
   suffix_flag |= Suffix::OMP;
   respa_enable = 0;
+
+  nthrbound = thrinum = maxthrcost = 0;
+  thrbound = NULL;
+  thrcost = NULL;
+  nthrshort = 0;
+  maxthrshort = NULL;
+  thrshort = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+
+PairSWOMP::~PairSWOMP()
+{
+  memory->destroy(thrbound);
+  memory->destroy(thrcost);
+  destroy_thrshort();
+  memory->destroy(cutghost);
+}
+
+/* ----------------------------------------------------------------------
+   owner mode needs the neighbors of ghost atoms for the three-body
+   terms centered on them and tallies the virial per interaction
+------------------------------------------------------------------------- */
+
+void PairSWOMP::init_style()
+{
+  PairSW::init_style();
+  destroy_thrshort();
+
+  if (sortflag != NONE)
+    error->all(FLERR,"Pair style sw/omp does not support the sort keyword");
+  if (tripflag)
+    error->all(FLERR,"Pair style sw/omp does not support the triplets keyword");
+
+  ghostneigh = ownerflag;
+  no_virial_fdotr_compute = ownerflag;
+  if (!ownerflag) return;
+
+  neighbor->requests[neighbor->nrequest-1]->ghost = 1;
+  if (comm->cutghostuser < 2.0*cutmax + neighbor->skin)
+    error->all(FLERR,"Pair style sw/omp owner yes requires a ghost "
+               "cutoff of twice the pair cutoff");
+
+  memory->destroy(cutghost);
+  memory->create(cutghost,atom->ntypes+1,atom->ntypes+1,"pair:cutghost");
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairSWOMP::init_one(int i, int j)
+{
+  double cut = PairSW::init_one(i,j);
+  if (ownerflag) cutghost[i][j] = cutghost[j][i] = cut;
+  return cut;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -45,6 +103,40 @@ void PairSWOMP::compute(int eflag, int vflag)
   const int nthreads = comm->nthreads;
   const int inum = list->inum;
 
+  // per thread ranges of the atom list with about equal estimated cost,
+  // redone when the neighbor list or the number of threads changes
+
+  const int sched = (schedflag == SCHED_COST) &&
+    (neighbor->ago == 0 || nthrbound != nthreads || thrinum != inum);
+
+  if (sched) {
+    if (inum > maxthrcost) {
+      maxthrcost = inum;
+      memory->destroy(thrcost);
+      memory->create(thrcost,maxthrcost,"pair:thrcost");
+    }
+    if (nthreads != nthrbound) {
+      nthrbound = nthreads;
+      memory->destroy(thrbound);
+      memory->create(thrbound,nthreads+1,"pair:thrbound");
+    }
+    thrinum = inum;
+  }
+
+  // per thread short lists persist across steps, add slots for new threads
+
+  if (nthreads > nthrshort) {
+    maxthrshort = (int *)
+      memory->srealloc(maxthrshort,nthreads*sizeof(int),"pair:maxthrshort");
+    thrshort = (int **)
+      memory->srealloc(thrshort,nthreads*sizeof(int *),"pair:thrshort");
+    for (int t = nthrshort; t < nthreads; t++) {
+      maxthrshort[t] = 0;
+      thrshort[t] = NULL;
+    }
+    nthrshort = nthreads;
+  }
+
 #if defined(_OPENMP)
 #pragma omp parallel default(none) shared(eflag,vflag)
 #endif
@@ -52,11 +144,34 @@ void PairSWOMP::compute(int eflag, int vflag)
     int ifrom, ito, tid;
 
     loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+
+    if (sched) {
+      cost_thr(ifrom, ito);
+      sync_threads();
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+      { cost_partition(inum, thrcost, nthreads, thrbound); }
+      sync_threads();
+    }
+    if (schedflag == SCHED_COST) {
+      ifrom = thrbound[tid];
+      ito = thrbound[tid+1];
+    }
+
     ThrData *thr = fix->get_thr(tid);
     thr->timer(Timer::START);
     ev_setup_thr(eflag, vflag, nall, eatom, vatom, thr);
 
-    if (evflag) {
+    if (ownerflag) {
+      if (evflag) {
+        if (eflag) {
+          eval_owner<1,1>(ifrom, ito, thr);
+        } else {
+          eval_owner<1,0>(ifrom, ito, thr);
+        }
+      } else eval_owner<0,0>(ifrom, ito, thr);
+    } else if (evflag) {
       if (eflag) {
         eval<1,1>(ifrom, ito, thr);
       } else {
@@ -65,14 +180,121 @@ void PairSWOMP::compute(int eflag, int vflag)
     } else eval<0,0>(ifrom, ito, thr);
 
     thr->timer(Timer::PAIR);
-    reduce_thr(this, eflag, vflag, thr);
+
+    // owner mode wrote all forces to atom->f directly and the per thread
+    // force arrays hold nothing of this style. reduce only energy and
+    // virial, unless a hybrid parent relies on us for the force reduction
+
+    if (ownerflag && force->pair == this) reduce_ev_thr(eflag, vflag, thr);
+    else reduce_thr(this, eflag, vflag, thr);
   } // end of omp parallel region
 }
 
+/* ----------------------------------------------------------------------
+   reduction of the per thread energy and virial of owner mode, without
+   the per thread forces. if this is the last /omp style of the step no
+   other style wrote to the per thread force arrays, so none is pending
+------------------------------------------------------------------------- */
+
+void PairSWOMP::reduce_ev_thr(const int eflag, const int vflag,
+                              ThrData * const thr)
+{
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int tid = thr->get_tid();
+
+  if (eflag || vflag) {
+    sync_threads();
+#if defined(_OPENMP)
+#pragma omp critical
+#endif
+    {
+      if (eflag & 1) eng_vdwl += thr->eng_vdwl;
+      if (vflag & 3)
+        for (int i = 0; i < 6; ++i) virial[i] += thr->virial_pair[i];
+    }
+  }
+  if (eflag & 2) data_reduce_thr(&(eatom[0]), nall, nthreads, 1, tid);
+  if (vflag & 4) data_reduce_thr(&(vatom[0][0]), nall, nthreads, 6, tid);
+
+  if (fix->last_omp_style == (void *) this) {
+    sync_threads();
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+    { fix->did_reduce(); }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   estimated cost of atom list entries ifrom to ito-1
+------------------------------------------------------------------------- */
+
+void PairSWOMP::cost_thr(int iifrom, int iito)
+{
+  int i,j,ii,jj,jnum,itype,jtype,ijparam,nshort;
+  double delx,dely,delz,rsq;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  const int * _noalias const type = atom->type;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  for (ii = iifrom; ii < iito; ++ii) {
+    i = ilist[ii];
+    itype = map[type[i]];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+    nshort = 0;
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      j &= NEIGHMASK;
+      delx = x[i].x - x[j].x;
+      dely = x[i].y - x[j].y;
+      delz = x[i].z - x[j].z;
+      rsq = delx*delx + dely*dely + delz*delz;
+      jtype = map[type[j]];
+      ijparam = elem2param[itype][jtype][jtype];
+      if (rsq < params[ijparam].cutsq) nshort++;
+    }
+    thrcost[ii] = atom_cost(jnum,nshort);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   make the short list of thread tid hold at least n neighbors, rounded
+   up to whole cache lines so lists of different threads share none.
+   called by that thread only, before the list is filled
+------------------------------------------------------------------------- */
+
+void PairSWOMP::grow_thrshort(int tid, int n)
+{
+  n = (n + 15) & ~15;
+  memory->destroy(thrshort[tid]);
+  memory->create(thrshort[tid],n,"pair:thrshort");
+  maxthrshort[tid] = n;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWOMP::destroy_thrshort()
+{
+  for (int t = 0; t < nthrshort; t++) memory->destroy(thrshort[t]);
+  memory->sfree(maxthrshort);
+  memory->sfree(thrshort);
+  nthrshort = 0;
+  maxthrshort = NULL;
+  thrshort = NULL;
+}
+
 template <int EVFLAG, int EFLAG>
 void PairSWOMP::eval(int iifrom, int iito, ThrData * const thr)
 {
-  int i,j,k,ii,jj,kk,jnum,jnumm1,maxshort_thr;
+  int i,j,k,ii,jj,kk,jnum,jnumm1;
   tagint itag,jtag;
   int itype,jtype,ktype,ijparam,ikparam,ijkparam;
   double xtmp,ytmp,ztmp,delx,dely,delz,evdwl,fpair;
@@ -91,8 +313,8 @@ void PairSWOMP::eval(int iifrom, int iito, ThrData * const thr)
   ilist = list->ilist;
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
-  maxshort_thr = maxshort;
-  memory->create(neighshort_thr,maxshort_thr,"pair_thr:neighshort_thr");
+  const int tid = thr->get_tid();
+  neighshort_thr = thrshort[tid];
 
   double fxtmp,fytmp,fztmp;
 
@@ -113,6 +335,10 @@ void PairSWOMP::eval(int iifrom, int iito, ThrData * const thr)
     jlist = firstneigh[i];
     jnum = numneigh[i];
     int numshort = 0;
+    if (jnum > maxthrshort[tid]) {
+      grow_thrshort(tid,jnum);
+      neighshort_thr = thrshort[tid];
+    }
 
     for (jj = 0; jj < jnum; jj++) {
       j = jlist[jj];
@@ -129,10 +355,6 @@ void PairSWOMP::eval(int iifrom, int iito, ThrData * const thr)
         continue;
       } else {
         neighshort_thr[numshort++] = j;
-        if (numshort >= maxshort_thr) {
-          maxshort_thr += maxshort_thr/2;
-          memory->grow(neighshort_thr,maxshort_thr,"pair:neighshort_thr");
-        }
       }
 
       jtag = tag[j];
@@ -207,7 +429,167 @@ void PairSWOMP::eval(int iifrom, int iito, ThrData * const thr)
     f[i].y += fytmp;
     f[i].z += fztmp;
   }
-  memory->destroy(neighshort_thr);
+}
+
+/* ----------------------------------------------------------------------
+   owner computes: each thread accumulates the complete force on its own
+   atoms straight into atom->f and writes no other atom. pair terms are
+   evaluated from both sides, and besides the triplets centered on I the
+   triplets centered on each short neighbor J with I as a leg are redone
+   for their force on I. forces go straight to atom->f, so the per thread
+   force arrays are neither written nor reduced; energy and virial are
+   tallied per interaction and reduced in reduce_ev_thr()
+------------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG>
+void PairSWOMP::eval_owner(int iifrom, int iito, ThrData * const thr)
+{
+  int i,j,k,ii,jj,kk,jnum,knum,jnumm1;
+  int itype,jtype,ktype,ijparam,ikparam,ijkparam,jkparam;
+  double xtmp,ytmp,ztmp,delx,dely,delz,evdwl,fpair;
+  double rsq,rsq1,rsq2;
+  double delr1[3],delr2[3],fj[3],fk[3];
+  int *ilist,*jlist,*klist,*numneigh,**firstneigh,*neighshort_thr;
+
+  evdwl = 0.0;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  dbl3_t * _noalias const f = (dbl3_t *) atom->f[0];
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+  const int tid = thr->get_tid();
+  neighshort_thr = thrshort[tid];
+
+  double fxtmp,fytmp,fztmp;
+
+  // loop over full neighbor list of my atoms
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    itype = map[type[i]];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    fxtmp = fytmp = fztmp = 0.0;
+
+    // two-body interactions, each side tallies half
+
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+    int numshort = 0;
+    if (jnum > maxthrshort[tid]) {
+      grow_thrshort(tid,jnum);
+      neighshort_thr = thrshort[tid];
+    }
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      j &= NEIGHMASK;
+
+      delx = xtmp - x[j].x;
+      dely = ytmp - x[j].y;
+      delz = ztmp - x[j].z;
+      rsq = delx*delx + dely*dely + delz*delz;
+
+      jtype = map[type[j]];
+      ijparam = elem2param[itype][jtype][jtype];
+      if (rsq >= params[ijparam].cutsq) continue;
+
+      neighshort_thr[numshort++] = j;
+
+      twobody(&params[ijparam],rsq,fpair,EFLAG,evdwl);
+
+      fxtmp += delx*fpair;
+      fytmp += dely*fpair;
+      fztmp += delz*fpair;
+
+      if (EVFLAG) ev_tally_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                               0.5*evdwl,0.0,0.5*fpair,delx,dely,delz,thr);
+    }
+
+    // three-body interactions centered on I
+
+    jnumm1 = numshort - 1;
+
+    for (jj = 0; jj < jnumm1; jj++) {
+      j = neighshort_thr[jj];
+      jtype = map[type[j]];
+      ijparam = elem2param[itype][jtype][jtype];
+      delr1[0] = x[j].x - xtmp;
+      delr1[1] = x[j].y - ytmp;
+      delr1[2] = x[j].z - ztmp;
+      rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+
+      for (kk = jj+1; kk < numshort; kk++) {
+        k = neighshort_thr[kk];
+        ktype = map[type[k]];
+        ikparam = elem2param[itype][ktype][ktype];
+        ijkparam = elem2param[itype][jtype][ktype];
+
+        delr2[0] = x[k].x - xtmp;
+        delr2[1] = x[k].y - ytmp;
+        delr2[2] = x[k].z - ztmp;
+        rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
+
+        threebody(&params[ijparam],&params[ikparam],&params[ijkparam],
+                  rsq1,rsq2,delr1,delr2,fj,fk,EFLAG,evdwl);
+
+        fxtmp -= fj[0] + fk[0];
+        fytmp -= fj[1] + fk[1];
+        fztmp -= fj[2] + fk[2];
+
+        if (EVFLAG) ev_tally3_thr(this,i,j,k,evdwl,0.0,fj,fk,delr1,delr2,thr);
+      }
+    }
+
+    // three-body interactions centered on J with I as first leg,
+    // only their force on I. energy and virial were tallied by J
+
+    for (jj = 0; jj < numshort; jj++) {
+      j = neighshort_thr[jj];
+      jtype = map[type[j]];
+      ijparam = elem2param[jtype][itype][itype];
+      delr1[0] = xtmp - x[j].x;
+      delr1[1] = ytmp - x[j].y;
+      delr1[2] = ztmp - x[j].z;
+      rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+      if (rsq1 >= params[ijparam].cutsq) continue;
+
+      klist = firstneigh[j];
+      knum = numneigh[j];
+
+      for (kk = 0; kk < knum; kk++) {
+        k = klist[kk];
+        k &= NEIGHMASK;
+        if (k == i) continue;
+
+        ktype = map[type[k]];
+        jkparam = elem2param[jtype][ktype][ktype];
+        delr2[0] = x[k].x - x[j].x;
+        delr2[1] = x[k].y - x[j].y;
+        delr2[2] = x[k].z - x[j].z;
+        rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
+        if (rsq2 >= params[jkparam].cutsq) continue;
+
+        ijkparam = elem2param[jtype][itype][ktype];
+        threebody(&params[ijparam],&params[jkparam],&params[ijkparam],
+                  rsq1,rsq2,delr1,delr2,fj,fk,0,evdwl);
+
+        fxtmp += fj[0];
+        fytmp += fj[1];
+        fztmp += fj[2];
+      }
+    }
+
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+  }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -216,6 +598,9 @@ double PairSWOMP::memory_usage()
 {
   double bytes = memory_usage_thr();
   bytes += PairSW::memory_usage();
+  bytes += maxthrcost * sizeof(double);
+  bytes += nthrbound * sizeof(int);
+  for (int t = 0; t < nthrshort; t++) bytes += maxthrshort[t] * sizeof(int);
 
   return bytes;
 }
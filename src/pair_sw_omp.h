@@ -33,16 +33,54 @@ class PairSWOMP : public PairSW, public ThrOMP {
 
  public:
   PairSWOMP(class LAMMPS *);
+  virtual ~PairSWOMP();
 
   virtual void compute(int, int);
+  virtual void init_style();
+  virtual double init_one(int, int);
   virtual double memory_usage();
 
  private:
+  int nthrbound;                // # of threads the ranges are made for
+  int thrinum;                  // # of atoms the ranges are made for
+  int *thrbound;                // first atom list entry of each thread
+  int maxthrcost;               // size of thrcost
+  double *thrcost;              // estimated cost of each atom list entry
+  int nthrshort;                // # of threads with a short list
+  int *maxthrshort;             // size of the short list of each thread
+  int **thrshort;               // short neighbor list of each thread
+
+  void cost_thr(int ifrom, int ito);
+  void grow_thrshort(int tid, int n);
+  void destroy_thrshort();
+  void reduce_ev_thr(const int eflag, const int vflag, ThrData * const thr);
+
   template <int EVFLAG, int EFLAG>
   void eval(int ifrom, int ito, ThrData * const thr);
+  template <int EVFLAG, int EFLAG>
+  void eval_owner(int ifrom, int ito, ThrData * const thr);
 };
 
 }
 
 #endif
 #endif
+
+/* ERROR/WARNING messages:
+
+E: Pair style sw/omp owner yes requires a ghost cutoff of twice the pair cutoff
+
+Threads compute the three-body terms centered on the neighbors of
+their atoms, which needs the neighbors of ghost atoms up to twice the
+pair cutoff plus the neighbor skin.  Use comm_modify cutoff.
+
+E: Pair style sw/omp does not support the sort keyword
+
+The threaded kernels keep the neighbor order of the short lists.
+
+E: Pair style sw/omp does not support the triplets keyword
+
+The threaded kernels evaluate the three-body terms from the short
+neighbor lists of every step and do not cache triplets.
+
+*/
@@ -0,0 +1,442 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------------
+   ordering of the neighbor lists of the Stillinger-Weber styles
+   sw, sw/woo and sw/wfnho, shared by their pair and triplet loops,
+   the cached triplet lists of their triplets option, and division of
+   the atom list among threads of their /omp variants.
+   the triplet functions are templates on the pair style, which is a
+   friend and provides the physics of a leg and a triplet:
+     shortcut(itype,jtype)  = candidate cutoff of a neighbor, w/o skin
+     legcut(m,side)         = cutoff of the i-j (0) or i-k (1) leg of set m
+     legcutsq(m,side)       = its square
+     legradial(m,side,rsq,e,de) = radial factor of that leg at r^2 = rsq
+     threebody(...)         = angular term from the radial factors
+     grow_short()           = grow the short list scratch to maxshort
+------------------------------------------------------------------------- */
+
+#ifndef LMP_PAIR_SW_SORT_H
+#define LMP_PAIR_SW_SORT_H
+
+#include "lmptype.h"
+
+namespace LAMMPS_NS {
+
+namespace PairSWSort {
+
+  // values of the sort keyword
+
+  enum{NONE,ELEMENT,DISTANCE};
+
+  // values of the schedule keyword
+
+  enum{SCHED_EVEN,SCHED_COST};
+
+  // columns of the per-atom work counts, see extract() of the styles
+
+  enum{WNEIGH,WTRIP,WSOFT,NWORK};
+
+  // rows of the per step geometry and radial factors of the legs
+
+  enum{LDELX,LDELY,LDELZ,LRSQ,LEXP,LDEXP,NLEGBUF};
+
+  // cached candidate triplet and the legs it combines
+
+  struct Triplet {
+    int i, j, k, m;                // atoms and parameter set
+    int lij, lik;                  // legs i-j and i-k
+  };
+
+  struct Leg {
+    int i, j, m;                   // atoms and parameter set
+    int side;                      // 0 for an i-j leg, 1 for an i-k leg
+  };
+
+  /* ----------------------------------------------------------------------
+     reorder the n short neighbors of one atom in neigh, with their r^2
+     in rsq and element in elem, into one contiguous block per element.
+     with sortflag = DISTANCE each block is also sorted by increasing r^2,
+     so triplet loops can stop at the first partner beyond a cutoff.
+     on return the neighbors of element e are first[e] to first[e+1]-1.
+     first has nelements+1 entries, tneigh and trsq are scratch of size n
+  ------------------------------------------------------------------------- */
+
+  inline void sort_short(int n, int nelements, int sortflag,
+                         int *neigh, double *rsq, int *elem, int *first,
+                         int *tneigh, double *trsq)
+  {
+    int e, m, mm, jtmp;
+    double rtmp;
+
+    // counting sort by element, first[e] is the insertion point of
+    // element e during the scatter and the end of its block afterwards
+
+    for (e = 0; e <= nelements; e++) first[e] = 0;
+    for (m = 0; m < n; m++) first[elem[m]+1]++;
+    for (e = 0; e < nelements; e++) first[e+1] += first[e];
+
+    for (m = 0; m < n; m++) {
+      mm = first[elem[m]]++;
+      tneigh[mm] = neigh[m];
+      trsq[mm] = rsq[m];
+    }
+    for (e = nelements; e > 0; e--) first[e] = first[e-1];
+    first[0] = 0;
+
+    for (e = 0; e < nelements; e++)
+      for (m = first[e]; m < first[e+1]; m++) {
+        neigh[m] = tneigh[m];
+        rsq[m] = trsq[m];
+        elem[m] = e;
+      }
+
+    if (sortflag != DISTANCE) return;
+
+    // insertion sort within each block, the blocks hold a few neighbors
+
+    for (e = 0; e < nelements; e++)
+      for (m = first[e]+1; m < first[e+1]; m++) {
+        jtmp = neigh[m];
+        rtmp = rsq[m];
+        for (mm = m-1; mm >= first[e] && rsq[mm] > rtmp; mm--) {
+          neigh[mm+1] = neigh[mm];
+          rsq[mm+1] = rsq[mm];
+        }
+        neigh[mm+1] = jtmp;
+        rsq[mm+1] = rtmp;
+      }
+  }
+
+  /* ----------------------------------------------------------------------
+     end[m] = one past the last neighbor of the run of equal elements
+     that contains neighbor m. triplet loops walk the k partners run by
+     run with the parameter set hoisted, a run is a whole element block
+     of a sorted list and usually a single neighbor of an unsorted one
+  ------------------------------------------------------------------------- */
+
+  inline void short_runs(int n, const int *elem, int *end)
+  {
+    if (n == 0) return;
+    end[n-1] = n;
+    for (int m = n-2; m >= 0; m--)
+      end[m] = (elem[m+1] == elem[m]) ? end[m+1] : m+1;
+  }
+
+  /* ----------------------------------------------------------------------
+     reorder the full neighbor list of each atom i in place so that the
+     neighbors j for which i computes the two-body term come first and
+     store their number in numhalf[i]. the owner of a pair is chosen by
+     the usual tag parity rule with coordinate tie-breaks for periodic
+     images, which does not change between reneighborings. the pair loop
+     then runs over the same full list and needs no tags or parity tests.
+     only the order within a list changes, so other users of the list
+     are not affected
+  ------------------------------------------------------------------------- */
+
+  inline void half_from_full(int inum, const int *ilist, const int *numneigh,
+                             int **firstneigh, const int *tag, double **x,
+                             int *numhalf)
+  {
+    int i, j, ii, jj, jnum, nhalf, itag, jtag, own;
+    int *jlist;
+
+    for (ii = 0; ii < inum; ii++) {
+      i = ilist[ii];
+      itag = tag[i];
+      jlist = firstneigh[i];
+      jnum = numneigh[i];
+
+      nhalf = 0;
+      for (jj = 0; jj < jnum; jj++) {
+        j = jlist[jj];
+        jtag = tag[j];
+        if (itag > jtag) own = (itag+jtag) % 2;
+        else if (itag < jtag) own = !((itag+jtag) % 2);
+        else {
+          if (x[j][2] < x[i][2]) own = 0;
+          else if (x[j][2] > x[i][2]) own = 1;
+          else if (x[j][1] < x[i][1]) own = 0;
+          else if (x[j][1] > x[i][1]) own = 1;
+          else own = (x[j][0] >= x[i][0]);
+        }
+        if (own) {
+          jlist[jj] = jlist[nhalf];
+          jlist[nhalf++] = j;
+        }
+      }
+      numhalf[i] = nhalf;
+    }
+  }
+
+  /* ----------------------------------------------------------------------
+     half_from_full() for the current list of a pair style, once per
+     neighbor list build as recorded in its halfbuild stamp
+  ------------------------------------------------------------------------- */
+
+  template <class PAIR>
+  void half_split(PAIR *pair)
+  {
+    if (pair->halfbuild == pair->neighbor->ncalls) return;
+    half_from_full(pair->list->inum, pair->list->ilist, pair->list->numneigh,
+                   pair->list->firstneigh, pair->atom->tag, pair->atom->x,
+                   pair->numhalf);
+    pair->halfbuild = pair->neighbor->ncalls;
+  }
+
+  /* ----------------------------------------------------------------------
+     list all triplets i,j,k of local atoms i that can come within the
+     three-body cutoffs before the next reneighboring, i.e. with both legs
+     inside cutoff + skin. the set only changes when neighbor lists are
+     rebuilt, so it is stored contiguously with its parameter sets.
+     every triplet refers to two legs, an i-j leg is shared by all
+     triplets with k of one element and an i-k leg by all with j of one
+     element, so the radial factors are computed once per leg and step
+  ------------------------------------------------------------------------- */
+
+  template <class PAIR>
+  void build_triplets(PAIR *pair)
+  {
+    int i, j, ii, jj, kk, inum, jnum, n, nl, itype, jtype, ktype, m, lij, lik;
+    double delx, dely, delz, rsq, cut;
+    int *ilist, *jlist, *numneigh, **firstneigh;
+
+    double **x = pair->atom->x;
+    int *type = pair->atom->type;
+    const int *map = pair->map;
+    const int nelements = pair->nelements;
+    int ***elem2param = pair->elem2param;
+    const double skin = pair->neighbor->skin;
+    int &ntrip = pair->ntrip;
+    int &maxtrip = pair->maxtrip;
+    int &nleg = pair->nleg;
+    int &maxleg = pair->maxleg;
+    Triplet *&trip = pair->trip;
+    Leg *&leg = pair->leg;
+    pair->tripbuild = pair->neighbor->ncalls;
+
+    inum = pair->list->inum;
+    ilist = pair->list->ilist;
+    numneigh = pair->list->numneigh;
+    firstneigh = pair->list->firstneigh;
+
+    ntrip = nleg = 0;
+    for (ii = 0; ii < inum; ii++) {
+      i = ilist[ii];
+      itype = map[type[i]];
+      jlist = firstneigh[i];
+      jnum = numneigh[i];
+
+      // candidates within the short cutoff plus skin
+
+      n = 0;
+      for (jj = 0; jj < jnum; jj++) {
+        j = jlist[jj];
+        j &= NEIGHMASK;
+        jtype = map[type[j]];
+        delx = x[i][0] - x[j][0];
+        dely = x[i][1] - x[j][1];
+        delz = x[i][2] - x[j][2];
+        rsq = delx*delx + dely*dely + delz*delz;
+        cut = pair->shortcut(itype, jtype) + skin;
+        if (rsq >= cut*cut) continue;
+
+        pair->shortrsq[n] = rsq;
+        pair->shortelem[n] = jtype;
+        pair->neighshort[n++] = j;
+        if (n >= pair->maxshort) {
+          pair->maxshort += pair->maxshort/2;
+          pair->grow_short();
+        }
+      }
+
+      if (ntrip + n*(n-1)/2 > maxtrip) {
+        maxtrip = ntrip + n*(n-1)/2 + maxtrip/2;
+        trip = (Triplet *)
+          pair->memory->srealloc(trip, maxtrip*sizeof(Triplet), "pair:trip");
+      }
+      if (nleg + 2*n*nelements > maxleg) {
+        maxleg = nleg + 2*n*nelements + maxleg/2;
+        leg = (Leg *) pair->memory->srealloc(leg, maxleg*sizeof(Leg), "pair:leg");
+        pair->memory->destroy(pair->legbuf);
+        pair->memory->create(pair->legbuf, NLEGBUF, maxleg, "pair:legbuf");
+      }
+
+      const int *neighshort = pair->neighshort;
+      const double *shortrsq = pair->shortrsq;
+      const int *shortelem = pair->shortelem;
+      int *legmap = pair->legmap;
+
+      // legmap = leg of short neighbor jj as the j (0) or k (1) leg
+      // of triplets whose other leg has element e, -1 if not used yet
+
+      nl = 2*n*nelements;
+      for (m = 0; m < nl; m++) legmap[m] = -1;
+
+      for (jj = 0; jj < n-1; jj++) {
+        jtype = shortelem[jj];
+        for (kk = jj+1; kk < n; kk++) {
+          ktype = shortelem[kk];
+          m = elem2param[itype][jtype][ktype];
+          cut = pair->legcut(m, 0) + skin;
+          if (shortrsq[jj] >= cut*cut) continue;
+          cut = pair->legcut(m, 1) + skin;
+          if (shortrsq[kk] >= cut*cut) continue;
+
+          lij = 2*(jj*nelements + ktype);
+          if (legmap[lij] < 0) {
+            legmap[lij] = nleg;
+            leg[nleg].i = i;
+            leg[nleg].j = neighshort[jj];
+            leg[nleg].m = m;
+            leg[nleg++].side = 0;
+          }
+          lik = 2*(kk*nelements + jtype) + 1;
+          if (legmap[lik] < 0) {
+            legmap[lik] = nleg;
+            leg[nleg].i = i;
+            leg[nleg].j = neighshort[kk];
+            leg[nleg].m = m;
+            leg[nleg++].side = 1;
+          }
+
+          Triplet &t = trip[ntrip++];
+          t.i = i;
+          t.j = neighshort[jj];
+          t.k = neighshort[kk];
+          t.m = m;
+          t.lij = legmap[lij];
+          t.lik = legmap[lik];
+        }
+      }
+    }
+  }
+
+  /* ----------------------------------------------------------------------
+     three-body terms from the cached triplet list in two flat loops,
+     one over the legs for the geometry and radial factors and one over
+     the triplets. legs and triplets currently beyond the cutoff are skipped
+  ------------------------------------------------------------------------- */
+
+  template <class PAIR>
+  void eval_triplets(PAIR *pair, int eflag)
+  {
+    int i, j, k, n, m;
+    double rsq, evdwl;
+    double delr1[3], delr2[3], fj[3], fk[3];
+
+    double **x = pair->atom->x;
+    double **f = pair->atom->f;
+    double **atomwork = pair->atomwork;
+    const int ntrip = pair->ntrip;
+    const int nleg = pair->nleg;
+    const Triplet *trip = pair->trip;
+    const Leg *leg = pair->leg;
+    double * const ldelx = pair->legbuf[LDELX];
+    double * const ldely = pair->legbuf[LDELY];
+    double * const ldelz = pair->legbuf[LDELZ];
+    double * const lrsq = pair->legbuf[LRSQ];
+    double * const lexp = pair->legbuf[LEXP];
+    double * const ldexp = pair->legbuf[LDEXP];
+
+    evdwl = 0.0;
+
+    for (n = 0; n < nleg; n++) {
+      const Leg &l = leg[n];
+      ldelx[n] = x[l.j][0] - x[l.i][0];
+      ldely[n] = x[l.j][1] - x[l.i][1];
+      ldelz[n] = x[l.j][2] - x[l.i][2];
+      rsq = ldelx[n]*ldelx[n] + ldely[n]*ldely[n] + ldelz[n]*ldelz[n];
+      lrsq[n] = rsq;
+      if (rsq >= pair->legcutsq(l.m, l.side)) continue;
+      pair->legradial(l.m, l.side, rsq, lexp[n], ldexp[n]);
+    }
+
+    for (n = 0; n < ntrip; n++) {
+      const Triplet &t = trip[n];
+      m = t.m;
+      if (lrsq[t.lij] >= pair->legcutsq(m, 0)) continue;
+      if (lrsq[t.lik] >= pair->legcutsq(m, 1)) continue;
+      i = t.i;
+      j = t.j;
+      k = t.k;
+      atomwork[i][WTRIP] += 1.0;
+
+      delr1[0] = ldelx[t.lij];
+      delr1[1] = ldely[t.lij];
+      delr1[2] = ldelz[t.lij];
+      delr2[0] = ldelx[t.lik];
+      delr2[1] = ldely[t.lik];
+      delr2[2] = ldelz[t.lik];
+
+      pair->threebody(&pair->params[m], lrsq[t.lij], lrsq[t.lik], delr1, delr2,
+                      lexp[t.lij], ldexp[t.lij], lexp[t.lik], ldexp[t.lik],
+                      fj, fk, eflag, evdwl);
+
+      f[i][0] -= fj[0] + fk[0];
+      f[i][1] -= fj[1] + fk[1];
+      f[i][2] -= fj[2] + fk[2];
+      f[j][0] += fj[0];
+      f[j][1] += fj[1];
+      f[j][2] += fj[2];
+      f[k][0] += fk[0];
+      f[k][1] += fk[1];
+      f[k][2] += fk[2];
+
+      if (pair->evflag)
+        pair->ev_tally3(i, j, k, evdwl, 0.0, fj, fk, delr1, delr2);
+    }
+  }
+
+  /* ----------------------------------------------------------------------
+     estimated cost of an atom with jnum neighbors of which nshort are
+     in the short list: one distance per neighbor plus the triplets,
+     which take a few times longer each
+  ------------------------------------------------------------------------- */
+
+  inline double atom_cost(int jnum, int nshort)
+  {
+    return jnum + 2.0*nshort*(nshort-1);
+  }
+
+  /* ----------------------------------------------------------------------
+     split the atom list into nthreads contiguous ranges of about equal
+     total cost, thread t gets entries bound[t] to bound[t+1]-1.
+     bound has nthreads+1 entries
+  ------------------------------------------------------------------------- */
+
+  inline void cost_partition(int inum, const double *cost, int nthreads,
+                             int *bound)
+  {
+    int ii, t;
+    double sum, total, target;
+
+    total = 0.0;
+    for (ii = 0; ii < inum; ii++) total += cost[ii];
+    target = total / nthreads;
+
+    bound[0] = 0;
+    t = 1;
+    sum = 0.0;
+    for (ii = 0; ii < inum && t < nthreads; ii++) {
+      sum += cost[ii];
+      while (t < nthreads && sum >= t*target) bound[t++] = ii+1;
+    }
+    while (t <= nthreads) bound[t++] = inum;
+  }
+
+}
+
+}
+
+#endif
@@ -25,6 +25,8 @@
 #include "stdlib.h"
 #include "string.h"
 #include "pair_sw_wfnho.h"
+#include "pair_sw_sort.h"
+#include "pair_sw_kernel.h"
 #include "atom.h"
 #include "neighbor.h"
 #include "neigh_request.h"
@@ -34,12 +36,27 @@
 #include "neighbor.h"
 #include "neigh_list.h"
 #include "memory.h"
+#include "update.h"
+#include "respa.h"
 #include "error.h"
+#include "suffix.h"
 
 using namespace LAMMPS_NS;
+using namespace PairSWSort;
+using namespace PairSWKernel;
 
 #define MAXLINE 1024
 #define DELTA 4
+#define TABINNER 0.5     // inner end of the tables in units of sigma
+#define TABTOL 1.0e-4    // warn if measured table error is larger
+#define TABFLOOR 1.0e-3  // table errors are relative to at least this
+                         // fraction of the largest scale beyond sigma
+
+// rows of the per short neighbor cache, the radial factors follow
+// RRAD with REXPJ..RDEXPK for each element of the other leg
+
+enum{RDELX,RDELY,RDELZ,RRSQ,RRAD};
+enum{REXPJ,RDEXPJ,REXPK,RDEXPK,NRAD};
 
 /* ---------------------------------------------------------------------- */
 
@@ -47,6 +64,7 @@ PairSWWFNHO::PairSWWFNHO(LAMMPS *lmp) : Pair(lmp)
 {
   single_enable = 0;
   one_coeff = 1;
+  respa_enable = 1;
   nelements = 0;
   elements = NULL;
   nparams = maxparam = 0;
@@ -55,6 +73,36 @@ PairSWWFNHO::PairSWWFNHO(LAMMPS *lmp) : Pair(lmp)
   elem2param = NULL;
   soft = NULL;
   elem2soft = NULL;
+  cutshortsq = NULL;
+
+  maxshort = 10;
+  neighshort = NULL;
+  shortrad = NULL;
+  shortrsq = sortrsq = NULL;
+  shortelem = shortend = sortneigh = shortfirst = NULL;
+  sortflag = NONE;
+  tripflag = 0;
+  schedflag = SCHED_COST;
+  ntrip = maxtrip = nleg = maxleg = 0;
+  trip = NULL;
+  tripbuild = -1;
+  leg = NULL;
+  legbuf = NULL;
+  legmap = NULL;
+
+  tabflag = ntable = 0;
+  tabpair_e = tabpair_f = NULL;
+  tabij_e = tabij_f = tabik_e = tabik_f = NULL;
+
+  // coordination numbers are stored per local and ghost atom
+  // ghost values are filled in by forward communication
+
+  comm_forward = 1;
+  nmax = 0;
+  coord = NULL;
+  numhalf = NULL;
+  halfbuild = -1;
+  atomwork = NULL;
 }
 
 /* ----------------------------------------------------------------------
@@ -69,33 +117,67 @@ PairSWWFNHO::~PairSWWFNHO()
   memory->destroy(params);
   memory->destroy(soft);
   memory->destroy(elem2param);
+  memory->destroy(cutshortsq);
+  memory->destroy(tabpair_e);
+  memory->destroy(tabpair_f);
+  memory->destroy(tabij_e);
+  memory->destroy(tabij_f);
+  memory->destroy(tabik_e);
+  memory->destroy(tabik_f);
+  memory->destroy(coord);
+  memory->destroy(numhalf);
+  memory->destroy(atomwork);
+  memory->destroy(shortrad);
+  memory->destroy(shortfirst);
+  memory->sfree(trip);
+  memory->sfree(leg);
+  memory->destroy(legbuf);
   
   if (allocated) {
     memory->destroy(setflag);
     memory->destroy(softflag);
     memory->destroy(cutsq);
+    memory->destroy(neighshort);
+    memory->destroy(shortrsq);
+    memory->destroy(shortelem);
+    memory->destroy(shortend);
+    memory->destroy(sortneigh);
+    memory->destroy(sortrsq);
+    memory->destroy(legmap);
     delete [] map;
-    delete [] coord;
   }
 }
 
 /* ---------------------------------------------------------------------- */
 void PairSWWFNHO::compute(int eflag, int vflag)
 {
-  int i, j, k, ii, jj, kk, inum, jnum, jnumm1, itag, jtag;
+  if (eflag || vflag) ev_setup(eflag, vflag);
+  else evflag = vflag_fdotr = 0;
+
+  eval_terms(eflag, 0);
+
+  if (vflag_fdotr) virial_fdotr_compute();
+}
+
+/* ----------------------------------------------------------------------
+   all terms of the potential, outer = 1 leaves out the forces of the
+   unsoftened pair terms and only tallies their energy and virial
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::eval_terms(int eflag, int outer)
+{
+  int i, j, k, ii, jj, kk, krun, kend, inum, jnum, jnumm1, numshort, jhalf;
+  int nsoftpair, ntrip_i;
   int itype, jtype, ktype, ijparam, ijkparam;
   double xtmp, ytmp, ztmp, delx, dely, delz, evdwl, fpair;
-  double rsq, rsq1, rsq2, bigr, bigd, gij, r;
+  double rsq, rsq1, rsq2, bigr, bigd, gij, r, dfc;
   double delr1[3], delr2[3], fj[3], fk[3];
   int *ilist, *jlist, *numneigh, **firstneigh;
   
   evdwl = 0.0;
-  if (eflag || vflag) ev_setup(eflag, vflag);
-  else evflag = vflag_fdotr = 0;
   
   double **x = atom->x;
   double **f = atom->f;
-  int *tag = atom->tag;
   int *type = atom->type;
   int nlocal = atom->nlocal;
   int newton_pair = force->newton_pair;
@@ -105,15 +187,28 @@ void PairSWWFNHO::compute(int eflag, int vflag)
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
 
+  // grow coordination array if necessary
+  // need to be atom->nmax in length
+
+  grow_peratom();
+
+  // work counts of local atoms are those of the current step
+
+  for (i = 0; i < nlocal; i++)
+    atomwork[i][WNEIGH] = atomwork[i][WTRIP] = atomwork[i][WSOFT] = 0.0;
+
+  // owned neighbors first in each list, redone when the list is rebuilt
+
+  half_split(this);
+
   // calculate coordination number for softening function
   for (ii = 0; ii < inum; ii++) {
     i = ilist[ii];
-    coord[tag[i]] = 0;
+    coord[i] = 0;
   }
 
   for (ii = 0; ii < inum; ii++) {
     i = ilist[ii];
-    itag = tag[i];
     itype = map[type[i]];
     xtmp = x[i][0];
     ytmp = x[i][1];
@@ -123,7 +218,6 @@ void PairSWWFNHO::compute(int eflag, int vflag)
     jnum = numneigh[i];
     for (jj = 0; jj < jnum; jj++) {
       j=jlist[jj];
-      jtag = tag[j];
       jtype = map[type[j]];
       
       if (softflag[itype][jtype]) {
@@ -136,61 +230,79 @@ void PairSWWFNHO::compute(int eflag, int vflag)
         rsq = delx*delx + dely*dely + delz*delz;
         r = sqrt(rsq) / params[ijparam].sigma;
         
-        if (r < (bigr - bigd)) coord[itag] += 1;
+        if (r < (bigr - bigd)) coord[i] += 1;
         else if (r < (bigr + bigd))
-          coord[itag] += 1 - (r-bigr+bigd)/(2*bigd) + sin(PIVAL*(r-bigr+bigd)/bigd)/(2*PIVAL);
+          coord[i] += soft_fc<0>(r-bigr+bigd, PIVAL/bigd, 0.5/bigd, dfc);
       }
     }
   }
 
+  // communicate coordination numbers of ghost atoms
+
+  comm->forward_comm_pair(this);
+
   // loop over full neighbor list of my atoms
 
   for (ii = 0; ii < inum; ii++) {
     i = ilist[ii];
-    itag = tag[i];
     itype = map[type[i]];
     xtmp = x[i][0];
     ytmp = x[i][1];
     ztmp = x[i][2];
 
-    // two-body interactions, skip half of them
+    // two-body interactions of the owned neighbors at the front of the list
 
     jlist = firstneigh[i];
     jnum = numneigh[i];
+    jhalf = numhalf[i];
+
+    numshort = nsoftpair = 0;
 
     for (jj = 0; jj < jnum; jj++) {
       j = jlist[jj];
-      jtag = tag[j];
-
-      if (itag > jtag) {
-         if ((itag+jtag) % 2 == 0) continue;
-      } 
-      else if (itag < jtag) {
-         if ((itag+jtag) % 2 == 1) continue;
-      }
-      else {
-        if (x[j][2] < ztmp) continue;
-        if (x[j][2] == ztmp && x[j][1] < ytmp) continue;
-        if (x[j][2] == ztmp && x[j][1] == ytmp && x[j][0] < xtmp) continue;
-      }
-
       jtype = map[type[j]];
  
       delx = xtmp - x[j][0];
       dely = ytmp - x[j][1];
       delz = ztmp - x[j][2];
       rsq = delx*delx + dely*dely + delz*delz;
+
+      // short list of neighbors that can take part in a three-body term
+
+      if (rsq < cutshortsq[itype][jtype]) {
+        shortrsq[numshort] = rsq;
+        shortelem[numshort] = jtype;
+        neighshort[numshort++] = j;
+        if (numshort >= maxshort) {
+          maxshort += maxshort/2;
+          grow_short();
+        }
+      }
+
+      if (jj >= jhalf) continue;
   
       ijparam = elem2param[itype][jtype][jtype];
       if (rsq > params[ijparam].cutpairsq) continue;
+
+      // unsoftened pairs are the rRESPA inner level, the outer level
+      // only tallies their energy and virial
+
+      if (outer && !softflag[itype][jtype] && !softflag[jtype][itype]) {
+        if (!evflag) continue;
+        twobody(&params[ijparam], rsq, fpair, eflag, evdwl);
+        ev_tally(i, j, nlocal, newton_pair, evdwl, 0.0, fpair, delx, dely, delz);
+        continue;
+      }
   
       twobody(&params[ijparam], rsq, fpair, eflag, evdwl);
   
-      if (softflag[itype][jtype]) 
-        gij = gsoft(coord[itag], itype, jtype);
-      else if (softflag[jtype][itype]) 
-        gij = gsoft(coord[jtag], jtype, itype);
-      else
+      if (softflag[itype][jtype]) {
+        gij = gsoft(coord[i], itype, jtype);
+        nsoftpair++;
+      } else if (softflag[jtype][itype]) {
+        gij = gsoft(coord[j], jtype, itype);
+        nsoftpair++;
+      } else
         gij = 1;
   
       evdwl = gij * evdwl;
@@ -207,65 +319,196 @@ void PairSWWFNHO::compute(int eflag, int vflag)
         ev_tally(i, j, nlocal, newton_pair, evdwl, 0.0, fpair, delx, dely, delz);
     }
 
-    jnumm1 = jnum - 1;
+    // three-body terms from the cached geometry and radial factors
+    // of the short neighbors
+
+    // the short neighbors are optionally grouped by element, so the
+    // k partners come in long runs of one element with hoisted parameters
+    // with cached triplets they are done after the atom loop instead
+
+    atomwork[i][WNEIGH] = jnum + 0.5*numshort*(numshort-1);
+    atomwork[i][WSOFT] = nsoftpair;
+    ntrip_i = 0;
+
+    jnumm1 = tripflag ? 0 : numshort - 1;
+    if (jnumm1 > 0) {
+      if (sortflag != NONE)
+        sort_short(numshort, nelements, sortflag, neighshort, shortrsq,
+                   shortelem, shortfirst, sortneigh, sortrsq);
+      short_runs(numshort, shortelem, shortend);
+      radial_short(i, itype, numshort);
+    }
 
     for (jj = 0; jj < jnumm1; jj++) {
-      j = jlist[jj];
-      jtype = map[type[j]];
-      delr1[0] = x[j][0] - xtmp;
-      delr1[1] = x[j][1] - ytmp;
-      delr1[2] = x[j][2] - ztmp;
-      rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+      j = neighshort[jj];
+      jtype = shortelem[jj];
+      delr1[0] = shortrad[RDELX][jj];
+      delr1[1] = shortrad[RDELY][jj];
+      delr1[2] = shortrad[RDELZ][jj];
+      rsq1 = shortrad[RRSQ][jj];
   
-      for (kk = jj+1; kk < jnum; kk++) {
-        k = jlist[kk];
-        ktype = map[type[k]];
+      for (kk = jj+1; kk < numshort; kk = kend) {
+        kend = shortend[kk];
+        ktype = shortelem[kk];
         ijkparam = elem2param[itype][jtype][ktype];
+        Param * const paramijk = &params[ijkparam];
     
-        if (rsq1 > params[ijkparam].cutijsq) continue;
-    
-        delr2[0] = x[k][0] - xtmp;
-        delr2[1] = x[k][1] - ytmp;
-        delr2[2] = x[k][2] - ztmp;
-        rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
+        if (rsq1 > paramijk->cutijsq) continue;
+
+        const double expj = shortrad[RRAD + NRAD*ktype + REXPJ][jj];
+        const double dexpj = shortrad[RRAD + NRAD*ktype + RDEXPJ][jj];
+        const double * const expk = shortrad[RRAD + NRAD*jtype + REXPK];
+        const double * const dexpk = shortrad[RRAD + NRAD*jtype + RDEXPK];
+
+        for (krun = kk; krun < kend; krun++) {
+          k = neighshort[krun];
+          rsq2 = shortrad[RRSQ][krun];
     
-        if (rsq2 > params[ijkparam].cutiksq) continue;
+          if (rsq2 > paramijk->cutiksq) {
+            if (sortflag == DISTANCE) break;
+            continue;
+          }
     
-        threebody(&params[ijkparam], rsq1, rsq2, delr1, delr2, fj, fk, eflag, evdwl);
+          delr2[0] = shortrad[RDELX][krun];
+          delr2[1] = shortrad[RDELY][krun];
+          delr2[2] = shortrad[RDELZ][krun];
+          ntrip_i++;
+
+          threebody(paramijk, rsq1, rsq2, delr1, delr2, expj, dexpj,
+                    expk[krun], dexpk[krun], fj, fk, eflag, evdwl);
     
-        f[i][0] -= fj[0] + fk[0];
-        f[i][1] -= fj[1] + fk[1];
-        f[i][2] -= fj[2] + fk[2];
-        f[j][0] += fj[0];
-        f[j][1] += fj[1];
-        f[j][2] += fj[2];
-        f[k][0] += fk[0];
-        f[k][1] += fk[1];
-        f[k][2] += fk[2];
+          f[i][0] -= fj[0] + fk[0];
+          f[i][1] -= fj[1] + fk[1];
+          f[i][2] -= fj[2] + fk[2];
+          f[j][0] += fj[0];
+          f[j][1] += fj[1];
+          f[j][2] += fj[2];
+          f[k][0] += fk[0];
+          f[k][1] += fk[1];
+          f[k][2] += fk[2];
         
-        if (evflag) 
-          ev_tally3(i, j, k, evdwl, 0.0, fj, fk, delr1, delr2);
+          if (evflag) 
+            ev_tally3(i, j, k, evdwl, 0.0, fj, fk, delr1, delr2);
+        }
       }
     }
+    atomwork[i][WTRIP] = ntrip_i;
+  }
+
+  if (tripflag) {
+    if (tripbuild != neighbor->ncalls) build_triplets(this);
+    eval_triplets(this, eflag);
   }
+}
+
+/* ----------------------------------------------------------------------
+   rRESPA inner level: pair terms of the bonds that no atom softens.
+   they depend on the distance only and are the stiffest forces.
+   softened bonds depend on the coordination numbers and are left to
+   the outer level, so for a mostly softened system, e.g. the Si-O
+   bonds of SiO2, the inner level holds little and rRESPA gains little
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::compute_inner()
+{
+  grow_peratom();
+  half_split(this);
+  pair_inner();
+}
+
+/* ----------------------------------------------------------------------
+   rRESPA outer level: softened pair terms, coordination forces and
+   three-body terms, i.e. everything but the inner level. energy and
+   virial are those of the whole potential, as with pairwise styles
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::compute_outer(int eflag, int vflag)
+{
+  if (eflag || vflag) ev_setup(eflag, vflag);
+  else evflag = vflag_fdotr = 0;
+
+  eval_terms(eflag, 1);
+
   if (vflag_fdotr) virial_fdotr_compute();
 }
 
+/* ----------------------------------------------------------------------
+   add the forces of the unsoftened pair terms, no tallies
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::pair_inner()
+{
+  int i, j, ii, jj, inum, jhalf, itype, jtype, ijparam;
+  double xtmp, ytmp, ztmp, delx, dely, delz, rsq, fpair, evdwl;
+  int *ilist, *jlist, **firstneigh;
+
+  double **x = atom->x;
+  double **f = atom->f;
+  int *type = atom->type;
+
+  inum = list->inum;
+  ilist = list->ilist;
+  firstneigh = list->firstneigh;
+
+  for (ii = 0; ii < inum; ii++) {
+    i = ilist[ii];
+    itype = map[type[i]];
+    xtmp = x[i][0];
+    ytmp = x[i][1];
+    ztmp = x[i][2];
+
+    jlist = firstneigh[i];
+    jhalf = numhalf[i];
+
+    for (jj = 0; jj < jhalf; jj++) {
+      j = jlist[jj];
+      jtype = map[type[j]];
+      if (softflag[itype][jtype] || softflag[jtype][itype]) continue;
+      ijparam = elem2param[itype][jtype][jtype];
+
+      delx = xtmp - x[j][0];
+      dely = ytmp - x[j][1];
+      delz = ztmp - x[j][2];
+      rsq = delx*delx + dely*dely + delz*delz;
+      if (rsq > params[ijparam].cutpairsq) continue;
+
+      twobody(&params[ijparam], rsq, fpair, 0, evdwl);
+
+      f[i][0] += delx * fpair;
+      f[i][1] += dely * fpair;
+      f[i][2] += delz * fpair;
+      f[j][0] -= delx * fpair;
+      f[j][1] -= dely * fpair;
+      f[j][2] -= delz * fpair;
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   grow per-atom arrays to atom->nmax
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::grow_peratom()
+{
+  if (atom->nmax <= nmax) return;
+
+  memory->destroy(coord);
+  memory->destroy(numhalf);
+  memory->destroy(atomwork);
+  nmax = atom->nmax;
+  memory->create(coord, nmax, "pair:coord");
+  memory->create(numhalf, nmax, "pair:numhalf");
+  memory->create(atomwork, nmax, NWORK, "pair:atomwork");
+}
+
 /* ---------------------------------------------------------------------- */
 
 double PairSWWFNHO::gsoft(double cn, int i, int j)
 {
-  double ma, mb, mc, md, me, first, second;
-  int ij = elem2soft[i][j];
-   
-  ma = soft[ij].ma;
-  mb = soft[ij].mb;
-  mc = soft[ij].mc;
-  md = soft[ij].md;
-  me = soft[ij].me;
-  first = ma / ( exp((mb - cn) / mc) + 1 );
-  second = exp(md * (cn - me) * (cn - me));
-  return first * second;
+  const Softparam &sp = soft[elem2soft[i][j]];
+  double dg;
+
+  return PairSWKernel::gsoft<0>(cn, sp.ma, sp.mb, 1.0/sp.mc, sp.md, sp.me, dg);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -274,13 +517,11 @@ void PairSWWFNHO::allocate()
 {
   allocated = 1;
   int n = atom->ntypes;
-  int num = ceil(atom->natoms);
 
-  coord = new double[num+1];
-  
   memory->create(setflag, n+1, n+1, "pair:setflag");
   memory->create(cutsq, n+1, n+1, "pair:cutsq");
   memory->create(softflag, n+1, n+1, "pair:softflag");
+  grow_short();
   
   map = new int[n+1];
 }
@@ -291,7 +532,58 @@ void PairSWWFNHO::allocate()
 
 void PairSWWFNHO::settings(int narg, char **arg)
 {
-  if (narg != 0) error->all(FLERR,"Illegal pair_style command");
+  // optional keywords:
+  // table N = tabulate the radial functions with N intervals in r^2
+  //   instead of evaluating pow/exp for every pair and triplet
+  // sort none/element/distance = order of the short neighbor list
+  //   used by the three-body loop, see pair_sw_sort.h
+  // triplets yes/no = cache the candidate triplets at reneighboring
+  //   and evaluate the three-body terms in flat loops over them
+  // schedule even/cost = division of the atoms among threads in the
+  //   /omp variant, equal counts or equal estimated cost
+
+  tabflag = ntable = 0;
+  sortflag = NONE;
+  tripflag = 0;
+  tripbuild = -1;
+  schedflag = SCHED_COST;
+
+  int iarg = 0;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg],"table") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      ntable = force->inumeric(FLERR,arg[iarg+1]);
+      if (ntable < 2) error->all(FLERR,"Illegal pair_style command");
+      tabflag = 1;
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"sort") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"none") == 0) sortflag = NONE;
+      else if (strcmp(arg[iarg+1],"element") == 0) sortflag = ELEMENT;
+      else if (strcmp(arg[iarg+1],"distance") == 0) sortflag = DISTANCE;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"triplets") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"yes") == 0) tripflag = 1;
+      else if (strcmp(arg[iarg+1],"no") == 0) tripflag = 0;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"schedule") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (!(suffix_flag & Suffix::OMP))
+        error->all(FLERR,"Pair style sw/wfnho keyword schedule requires "
+                   "pair style sw/wfnho/omp");
+      if (strcmp(arg[iarg+1],"even") == 0) schedflag = SCHED_EVEN;
+      else if (strcmp(arg[iarg+1],"cost") == 0) schedflag = SCHED_COST;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else error->all(FLERR,"Illegal pair_style command");
+  }
+
+  // re-tabulate if the potential was already read in
+
+  if (nparams) tabulate();
 }
 
 /* ----------------------------------------------------------------------
@@ -382,6 +674,18 @@ void PairSWWFNHO::init_style()
   int irequest = neighbor->request(this, instance_me);
   neighbor->requests[irequest]->half = 0;
   neighbor->requests[irequest]->full = 1;
+
+  // rRESPA splits the potential by terms, not by distance,
+  // into the inner and outer levels only, so the inner cutoffs are unused
+
+  if (update->whichflag == 1 && strstr(update->integrate_style,"respa")) {
+    Respa *respa = (Respa *) update->integrate;
+    if (respa->level_middle >= 0)
+      error->all(FLERR,"Pair style sw/wfnho does not support rRESPA middle level");
+    if (respa->level_inner >= 0 &&
+        (respa->cutoff[0] != 0.0 || respa->cutoff[1] != 0.0))
+      error->all(FLERR,"Pair style sw/wfnho requires rRESPA inner cutoffs of 0.0");
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -390,9 +694,33 @@ void PairSWWFNHO::init_style()
 
 double PairSWWFNHO::init_one(int i, int j)
 {
+  int n, m, ielement, jelement, isoft;
+  double rtmp, cutone;
+
   if (setflag[i][j] == 0) error->all(FLERR,"All pair coeffs are not set");
 
-  return cutmax;
+  // cutoff for this type pair only, with the elements in either order:
+  // two-body cutoff, largest three-body leg that can connect them,
+  // and the range of the cutoff function in the coordination number
+
+  cutone = 0.0;
+  for (n = 0; n < 2; n++) {
+    ielement = (n == 0) ? map[i] : map[j];
+    jelement = (n == 0) ? map[j] : map[i];
+    m = elem2param[ielement][jelement][jelement];
+
+    if (params[m].cutpair > cutone) cutone = params[m].cutpair;
+    rtmp = sqrt(cutshortsq[ielement][jelement]);
+    if (rtmp > cutone) cutone = rtmp;
+
+    if (softflag[ielement][jelement]) {
+      isoft = elem2soft[ielement][jelement];
+      rtmp = (soft[isoft].bigr + soft[isoft].bigd) * params[m].sigma;
+      if (rtmp > cutone) cutone = rtmp;
+    }
+  }
+
+  return cutone;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -684,6 +1012,26 @@ void PairSWWFNHO::setup()
                    pow(params[m].sigma, params[m].powerq);
   }
 
+  // set cutshortsq for each element pair I,J to the largest three-body
+  // cutoff in which J can appear, as the IJ leg or as the IK leg
+
+  if (cutshortsq) memory->destroy(cutshortsq);
+  memory->create(cutshortsq, nelements, nelements, "pair:cutshortsq");
+
+  for (i = 0; i < nelements; i++) {
+    for (j = 0; j < nelements; j++) {
+      cutshortsq[i][j] = 0.0;
+      for (k = 0; k < nelements; k++) {
+        n = elem2param[i][j][k];
+        if (params[n].cutijsq > cutshortsq[i][j]) 
+          cutshortsq[i][j] = params[n].cutijsq;
+        n = elem2param[i][k][j];
+        if (params[n].cutiksq > cutshortsq[i][j]) 
+          cutshortsq[i][j] = params[n].cutiksq;
+      }
+    }
+  }
+
   // set cutmax to max of all params
 
   cutmax = 0.0;
@@ -695,24 +1043,218 @@ void PairSWWFNHO::setup()
     rtmp3 = sqrt(params[m].cutiksq);
     if (rtmp3 > cutmax) cutmax = rtmp3;
   }
+
+  tabulate();
+
+  // the short neighbor cache has rows for every element
+
+  grow_short();
+  memory->destroy(shortfirst);
+  memory->create(shortfirst, nelements+1, "pair:shortfirst");
+}
+
+/* ----------------------------------------------------------------------
+   (re)allocate the short neighbor list and its per neighbor data
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::grow_short()
+{
+  memory->grow(neighshort, maxshort, "pair:neighshort");
+  memory->grow(shortrsq, maxshort, "pair:shortrsq");
+  memory->grow(shortelem, maxshort, "pair:shortelem");
+  memory->grow(shortend, maxshort, "pair:shortend");
+  memory->grow(sortneigh, maxshort, "pair:sortneigh");
+  memory->grow(sortrsq, maxshort, "pair:sortrsq");
+  memory->destroy(shortrad);
+  memory->create(shortrad, RRAD + NRAD*nelements, maxshort, "pair:shortrad");
+  memory->destroy(legmap);
+  memory->create(legmap, 2*maxshort*nelements, "pair:legmap");
+}
+
+/* ----------------------------------------------------------------------
+   tabulate the two-body energy and force and the two three-body radial
+   factors of every parameter set as functions of r^2
+
+   each table has ntable intervals between (TABINNER*sigma)^2 and the
+   cutoff squared, plus two zero entries at the cutoff. all functions
+   vanish smoothly there. pairs and triplet legs closer than the
+   inner end fall back to analytic evaluation.
+
+   linear interpolation in u = r^2 with spacing h has an error of at
+   most h^2/8 * max|d^2f/du^2| per interval. the actual error is
+   measured at the interval midpoints beyond r = sigma, i.e. over the
+   distances atoms normally have, and printed. a warning is issued above
+   TABTOL. errors of e and r^2*f are relative to the local scale
+   |e| + r^2*|f|, which does not vanish where e or f change sign.
+   a floor of TABFLOOR times its largest value beyond sigma keeps the
+   tails that vanish at the cutoff from dominating
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::tabulate()
+{
+  int m, n, tabsave;
+  double lo, hi, delta, rsq, rsqmin, e, f, et, ft, scale, smax, err, errmax;
+
+  memory->destroy(tabpair_e);
+  memory->destroy(tabpair_f);
+  memory->destroy(tabij_e);
+  memory->destroy(tabij_f);
+  memory->destroy(tabik_e);
+  memory->destroy(tabik_f);
+  tabpair_e = tabpair_f = NULL;
+  tabij_e = tabij_f = tabik_e = tabik_f = NULL;
+
+  if (!tabflag || nparams == 0) return;
+
+  memory->create(tabpair_e, nparams, ntable+2, "pair:tabpair_e");
+  memory->create(tabpair_f, nparams, ntable+2, "pair:tabpair_f");
+  memory->create(tabij_e, nparams, ntable+2, "pair:tabij_e");
+  memory->create(tabij_f, nparams, ntable+2, "pair:tabij_f");
+  memory->create(tabik_e, nparams, ntable+2, "pair:tabik_e");
+  memory->create(tabik_f, nparams, ntable+2, "pair:tabik_f");
+
+  // twobody() must not use the tables while they are filled
+
+  tabsave = tabflag;
+  tabflag = 0;
+  errmax = 0.0;
+
+  for (m = 0; m < nparams; m++) {
+    lo = TABINNER * params[m].sigma;
+    lo = lo * lo;
+
+    // two-body energy and force
+
+    hi = params[m].cutpairsq;
+    if (lo > 0.25 * hi) lo = 0.25 * hi;
+    delta = (hi - lo) / ntable;
+    params[m].tabpairlo = lo;
+    params[m].tabpairinv = 1.0 / delta;
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + n * delta;
+      twobody(&params[m], rsq, tabpair_f[m][n], 1, tabpair_e[m][n]);
+    }
+    tabpair_e[m][ntable] = tabpair_e[m][ntable+1] = 0.0;
+    tabpair_f[m][ntable] = tabpair_f[m][ntable+1] = 0.0;
+
+    rsqmin = params[m].sigma * params[m].sigma;
+    smax = 0.0;
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + n * delta;
+      if (rsq < rsqmin) continue;
+      scale = fabs(tabpair_e[m][n]) + rsq * fabs(tabpair_f[m][n]);
+      if (scale > smax) smax = scale;
+    }
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + (n + 0.5) * delta;
+      if (rsq < rsqmin) continue;
+      twobody(&params[m], rsq, f, 1, e);
+      tab_lookup(tabpair_e[m], tabpair_f[m], lo, params[m].tabpairinv, rsq, et, ft);
+      scale = fabs(e) + rsq * fabs(f) + TABFLOOR * smax;
+      if ((err = fabs(et - e) / scale) > errmax) errmax = err;
+      if ((err = rsq * fabs(ft - f) / scale) > errmax) errmax = err;
+    }
+
+    // three-body radial factors of the ij and the ik leg
+
+    lo = TABINNER * params[m].sigma;
+    lo = lo * lo;
+    hi = params[m].cutijsq;
+    if (lo > 0.25 * hi) lo = 0.25 * hi;
+    delta = (hi - lo) / ntable;
+    params[m].tabijlo = lo;
+    params[m].tabijinv = 1.0 / delta;
+    tabulate_radial(ntable, TABFLOOR, tabij_e[m], tabij_f[m], lo, delta,
+                    rsqmin, params[m].cutij, params[m].sigma_gammaij, errmax);
+
+    lo = TABINNER * params[m].sigma;
+    lo = lo * lo;
+    hi = params[m].cutiksq;
+    if (lo > 0.25 * hi) lo = 0.25 * hi;
+    delta = (hi - lo) / ntable;
+    params[m].tabiklo = lo;
+    params[m].tabikinv = 1.0 / delta;
+    tabulate_radial(ntable, TABFLOOR, tabik_e[m], tabik_f[m], lo, delta,
+                    rsqmin, params[m].cutik, params[m].sigma_gammaik, errmax);
+  }
+
+  tabflag = tabsave;
+
+  if (comm->me == 0) {
+    if (screen)
+      fprintf(screen,"  sw/wfnho tables: %d intervals, max relative error %g "
+              "beyond sigma\n",
+              ntable, errmax);
+    if (logfile)
+      fprintf(logfile,"  sw/wfnho tables: %d intervals, max relative error %g "
+              "beyond sigma\n",
+              ntable, errmax);
+  }
+  if (errmax > TABTOL && comm->me == 0)
+    error->warning(FLERR,"Pair sw/wfnho table error is large, increase table size");
 }
 
 /* ---------------------------------------------------------------------- */
 void PairSWWFNHO::twobody(Param *param, double rsq, double &fforce,
                           int eflag, double &eng)
 {
-  double r, rinvsq, rp, rq, rainv, rainvsq, expsrainv;
-  
-  r = sqrt(rsq);
-  rinvsq = 1.0 / rsq;
-  rp = pow(r, -param->powerp);
-  rq = pow(r, -param->powerq);
-  rainv = 1.0 / (r - param->cutpair);
-  rainvsq = rainv * rainv * r;
-  expsrainv = exp(param->sigma * rainv);
-  fforce = (param->c1 * rp - param->c2 * rq +
-            (param->c3 * rp - param->c4 * rq) * rainvsq) * expsrainv * rinvsq;
-  if (eflag) eng = (param->c5 * rp - param->c6 * rq) * expsrainv;
+  if (tabflag && rsq > param->tabpairlo) {
+    int m = param - params;
+    tab_lookup(tabpair_e[m], tabpair_f[m], param->tabpairlo, param->tabpairinv,
+               rsq, eng, fforce);
+    return;
+  }
+
+  PairSWKernel::twobody(param, param->cutpair, rsq, fforce, eflag, eng);
+}
+
+/* ----------------------------------------------------------------------
+   geometry and three-body radial factors of the numshort short
+   neighbors of atom i. a neighbor is the j leg of some triplets and
+   the k leg of others, with parameters that depend on the element of
+   the other leg, so both are stored for every element of the other leg
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::radial_short(int i, int itype, int numshort)
+{
+  int j, jj, jtype, e, m;
+  double rsq, r;
+
+  double **x = atom->x;
+  int *type = atom->type;
+  double **c = shortrad;
+
+  for (jj = 0; jj < numshort; jj++) {
+    j = neighshort[jj];
+    jtype = map[type[j]];
+    c[RDELX][jj] = x[j][0] - x[i][0];
+    c[RDELY][jj] = x[j][1] - x[i][1];
+    c[RDELZ][jj] = x[j][2] - x[i][2];
+    rsq = c[RDELX][jj]*c[RDELX][jj] + c[RDELY][jj]*c[RDELY][jj] +
+      c[RDELZ][jj]*c[RDELZ][jj];
+    c[RRSQ][jj] = rsq;
+    r = sqrt(rsq);
+
+    for (e = 0; e < nelements; e++) {
+      double ** const ce = c + RRAD + NRAD*e;
+
+      m = elem2param[itype][jtype][e];
+      if (rsq > params[m].cutijsq) ce[REXPJ][jj] = ce[RDEXPJ][jj] = 0.0;
+      else if (tabflag && rsq > params[m].tabijlo)
+        tab_lookup(tabij_e[m], tabij_f[m], params[m].tabijlo,
+                   params[m].tabijinv, rsq, ce[REXPJ][jj], ce[RDEXPJ][jj]);
+      else exp_radial(r, params[m].cutij, params[m].sigma_gammaij,
+                      ce[REXPJ][jj], ce[RDEXPJ][jj]);
+
+      m = elem2param[itype][e][jtype];
+      if (rsq > params[m].cutiksq) ce[REXPK][jj] = ce[RDEXPK][jj] = 0.0;
+      else if (tabflag && rsq > params[m].tabiklo)
+        tab_lookup(tabik_e[m], tabik_f[m], params[m].tabiklo,
+                   params[m].tabikinv, rsq, ce[REXPK][jj], ce[RDEXPK][jj]);
+      else exp_radial(r, params[m].cutik, params[m].sigma_gammaik,
+                      ce[REXPK][jj], ce[RDEXPK][jj]);
+    }
+  }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -722,52 +1264,88 @@ void PairSWWFNHO::threebody(Param *paramijk,
                            double *delr1, double *delr2,
                            double *fj, double *fk, int eflag, double &eng)
 {
-  double r1, rinvsq1, rainv1, gsrainv1, gsrainvsq1, expgsrainv1;
-  double r2, rinvsq2, rainv2, gsrainv2, gsrainvsq2, expgsrainv2;
-  double rinv12, cs, delcs, delcssq, facexp, facrad, frad1, frad2;
-  double facang, facang12, csfacang, csfac1, csfac2;
-  
-  r1 = sqrt(rsq1);
-  rinvsq1 = 1.0 / rsq1;
-  rainv1 = 1.0 / (r1 - paramijk->cutij);
-  gsrainv1 = paramijk->sigma_gammaij * rainv1;
-  gsrainvsq1 = gsrainv1 * rainv1 / r1;
-  expgsrainv1 = exp(gsrainv1);
-  
-  r2 = sqrt(rsq2);
-  rinvsq2 = 1.0 / rsq2;
-  rainv2 = 1.0 / (r2 - paramijk->cutik);
-  gsrainv2 = paramijk->sigma_gammaik * rainv2;
-  gsrainvsq2 = gsrainv2 * rainv2 / r2;
-  expgsrainv2 = exp(gsrainv2);
-  
-  rinv12 = 1.0 / (r1 * r2);
-  cs = (delr1[0]*delr2[0] + delr1[1]*delr2[1] + delr1[2]*delr2[2]) * rinv12;
-  delcs = cs - paramijk->costheta;
-  delcssq = delcs * delcs;
-  
-  facexp = expgsrainv1 * expgsrainv2;
-  
-  // facrad = sqrt(paramijk->lambda_epsilon*paramijk->lambda_epsilon) *
-  //       facexp*delcssq;
-  
-  facrad = paramijk->lambda_epsilon * facexp * delcssq;
-  frad1 = facrad * gsrainvsq1;
-  frad2 = facrad * gsrainvsq2;
-  facang = paramijk->lambda_epsilon2 * facexp*delcs;
-  facang12 = rinv12 * facang;
-  csfacang = cs * facang;
-  csfac1 = rinvsq1 * csfacang;
-  
-  fj[0] = delr1[0] * (frad1 + csfac1) - delr2[0] * facang12;
-  fj[1] = delr1[1] * (frad1 + csfac1) - delr2[1] * facang12;
-  fj[2] = delr1[2] * (frad1 + csfac1) - delr2[2] * facang12;
-  
-  csfac2 = rinvsq2 * csfacang;
-  
-  fk[0] = delr2[0] * (frad2 + csfac2) - delr1[0] * facang12;
-  fk[1] = delr2[1] * (frad2 + csfac2) - delr1[1] * facang12;
-  fk[2] = delr2[2] * (frad2 + csfac2) - delr1[2] * facang12;
-  
-  if (eflag) eng = facrad;
+  double expgsrainv1, dexpgsrainv1, expgsrainv2, dexpgsrainv2;
+  const int m = paramijk - params;
+
+  legradial(m, 0, rsq1, expgsrainv1, dexpgsrainv1);
+  legradial(m, 1, rsq2, expgsrainv2, dexpgsrainv2);
+
+  threebody(paramijk, rsq1, rsq2, delr1, delr2, expgsrainv1, dexpgsrainv1,
+            expgsrainv2, dexpgsrainv2, fj, fk, eflag, eng);
+}
+
+/* ----------------------------------------------------------------------
+   three-body term with the radial factors of both legs given
+------------------------------------------------------------------------- */
+
+void PairSWWFNHO::threebody(Param *paramijk,
+                           double rsq1, double rsq2,
+                           double *delr1, double *delr2,
+                           double expgsrainv1, double dexpgsrainv1,
+                           double expgsrainv2, double dexpgsrainv2,
+                           double *fj, double *fk, int eflag, double &eng)
+{
+  PairSWKernel::threebody<0>(paramijk->lambda_epsilon, paramijk->lambda_epsilon2,
+                             paramijk->costheta, 0.0, rsq1, rsq2,
+                             delr1, delr2, expgsrainv1, dexpgsrainv1,
+                             expgsrainv2, dexpgsrainv2, fj, fk, eflag, eng);
+}
+
+/* ---------------------------------------------------------------------- */
+
+int PairSWWFNHO::pack_forward_comm(int n, int *list, double *buf,
+                                int pbc_flag, int *pbc)
+{
+  int i, j, m;
+
+  m = 0;
+  for (i = 0; i < n; i++) {
+    j = list[i];
+    buf[m++] = coord[j];
+  }
+  return m;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWFNHO::unpack_forward_comm(int n, int first, double *buf)
+{
+  int i, m, last;
+
+  m = 0;
+  last = first + n;
+  for (i = first; i < last; i++) coord[i] = buf[m++];
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of local atom-based arrays
+------------------------------------------------------------------------- */
+
+double PairSWWFNHO::memory_usage()
+{
+  double bytes = nmax * sizeof(double);
+  bytes += nmax * sizeof(int);
+  if (atomwork) bytes += NWORK * nmax * sizeof(double);
+  bytes += maxshort * (RRAD + NRAD*nelements) * sizeof(double);
+  bytes += maxshort * 3 * (sizeof(int) + sizeof(double));
+  bytes += 2 * maxshort * nelements * sizeof(int);
+  bytes += maxtrip * sizeof(Triplet);
+  bytes += maxleg * (sizeof(Leg) + NLEGBUF*sizeof(double));
+  return bytes;
+}
+
+/* ----------------------------------------------------------------------
+   atomwork = per-atom work of the last step for load balancing,
+   nlocal x 3 and not per type like the arrays of other pair styles,
+   one row per local atom with the # of neighbor and neighbor-of-neighbor
+   visits, of evaluated triplets and of softened pairs it computed
+------------------------------------------------------------------------- */
+
+void *PairSWWFNHO::extract(const char *str, int &dim)
+{
+  if (strcmp(str,"atomwork") == 0) {
+    dim = 2;
+    return (void *) atomwork;
+  }
+  return NULL;
 }
@@ -30,6 +30,8 @@ PairStyle(sw/wfnho, PairSWWFNHO)
 #define LMP_PAIR_SW_WFNHO_H
 
 #include "pair.h"
+#include "pair_sw_kernel.h"
+#include "pair_sw_sort.h"
 #define PIVAL 3.1415926535898
 
 namespace LAMMPS_NS {
@@ -39,10 +41,27 @@ class PairSWWFNHO : public Pair {
   PairSWWFNHO(class LAMMPS *);
   virtual ~PairSWWFNHO();
   virtual void compute(int, int);
+
+  // rRESPA: the inner level holds only the bonds no atom softens, the
+  // softened ones stay on the outer level with everything that depends
+  // on the coordination numbers. a system where most bonds are softened,
+  // like Si-O in SiO2, gains little from rRESPA
+  virtual void compute_inner();
+  virtual void compute_outer(int, int);
   void settings(int, char **);
   virtual void coeff(int, char **);
   virtual double init_one(int, int);
   virtual void init_style();
+  virtual int pack_forward_comm(int, int *, double *, int, int *);
+  virtual void unpack_forward_comm(int, int, double *);
+  virtual double memory_usage();
+
+  // extract("atomwork") sets dim = 2 and returns the per-atom work
+  // counts as double[nlocal][3]: neighbor visits, triplets and softened
+  // pairs of the last step, indexed by local atom. the array moves when
+  // the number of atoms grows, so callers look it up again every step.
+  // no other name is extracted and dim is left unchanged for them
+  virtual void *extract(const char *, int &);
 
   struct Param {
     double epsilon, sigma;
@@ -53,6 +72,7 @@ class PairSWWFNHO : public Pair {
     double cutpair, cutij, cutik, cutpairsq, cutijsq, cutiksq;
     double sigma_gammaij, sigma_gammaik, lambda_epsilon, lambda_epsilon2;
     double c1, c2, c3, c4, c5, c6;
+    double tabpairlo, tabpairinv, tabijlo, tabijinv, tabiklo, tabikinv;
     int ielement, jelement, kelement;
   };
 
@@ -61,6 +81,11 @@ class PairSWWFNHO : public Pair {
     int ielement, jelement;
   };
 
+  // cached candidate triplet and the legs it combines
+
+  typedef PairSWSort::Triplet Triplet;
+  typedef PairSWSort::Leg Leg;
+
  protected:
 
   double cutmax;             // max cutoff for all elements
@@ -76,18 +101,101 @@ class PairSWWFNHO : public Pair {
   int maxsofts;              // max # of softening parameter sets
   Softparam *soft;           // parameter set for the bond softening
   int **softflag;
-  double *coord;
+  double **cutshortsq;       // short neighbor list cutoff for element pairs
+  int maxshort;              // size of short neighbor list array
+  int *neighshort;           // short neighbor list array
+  double **shortrad;         // SoA geometry and radial factors of short neighbors
+  double *shortrsq;          // r^2 of short neighbors
+  int *shortelem;            // element of short neighbors
+  int *shortend;             // end of the run of equal elements
+  int *shortfirst;           // first short neighbor of each element
+  int *sortneigh;            // scratch for sorting the short list
+  double *sortrsq;
+  int sortflag;              // ordering of the short list
+  int tripflag;              // 1 if triplets are cached between reneighborings
+  int schedflag;             // division of the atoms among threads
+  int ntrip, maxtrip;        // # of cached triplets and size of trip
+  Triplet *trip;             // cached candidate triplets
+  bigint tripbuild;          // neighbor list build trip was made for
+  int nleg, maxleg;          // # of legs and size of leg
+  Leg *leg;                  // legs of the cached triplets
+  double **legbuf;           // per step geometry and radial factors of legs
+  int *legmap;               // scratch to number the legs of one atom
+  int tabflag;               // 1 if radial functions are tabulated
+  int ntable;                // # of table intervals in r^2
+  double **tabpair_e;        // tabulated two-body energy
+  double **tabpair_f;        // tabulated two-body force / r
+  double **tabij_e, **tabik_e;  // tabulated three-body radial factors
+  double **tabij_f, **tabik_f;  // and their derivative terms
+  int nmax;                  // allocated size of per-atom arrays
+  double *coord;             // coordination number of local and ghost atoms
+  int *numhalf;              // # of neighbors at the front of the list owned by I
+  bigint halfbuild;          // neighbor list build numhalf was made for
+  double **atomwork;         // work counts of local atoms, see extract()
   
   virtual void allocate();
+  void grow_peratom();
+  void pair_inner();
+  void eval_terms(int, int);
+  void grow_short();
   void read_file(char *);
   virtual void setup();
+  void tabulate();
   void twobody(Param *, double, double &, int, double &);
   void threebody(Param *, double, double, double *, double *,
                     double *, double *, int, double &);
+  void threebody(Param *, double, double, double *, double *,
+                 double, double, double, double,
+                 double *, double *, int, double &);
+  void radial_short(int, int, int);
   double gsoft(double, int, int);
+
+  // cached triplets of the triplets option, built and evaluated by the
+  // templates in pair_sw_sort.h, which call the leg functions below
+
+  template <class PAIR> friend void PairSWSort::half_split(PAIR *);
+  template <class PAIR> friend void PairSWSort::build_triplets(PAIR *);
+  template <class PAIR> friend void PairSWSort::eval_triplets(PAIR *, int);
+
+  double shortcut(int itype, int jtype) const {
+    return sqrt(cutshortsq[itype][jtype]);
+  }
+  double legcut(int m, int side) const {
+    return side ? params[m].cutik : params[m].cutij;
+  }
+  double legcutsq(int m, int side) const {
+    return side ? params[m].cutiksq : params[m].cutijsq;
+  }
+  void legradial(int m, int side, double rsq, double &e, double &de) const {
+    const Param &p = params[m];
+    if (side == 0) {
+      if (tabflag && rsq > p.tabijlo)
+        PairSWKernel::tab_lookup(tabij_e[m], tabij_f[m], p.tabijlo, p.tabijinv,
+                                 rsq, e, de);
+      else PairSWKernel::exp_radial(sqrt(rsq), p.cutij, p.sigma_gammaij, e, de);
+    } else {
+      if (tabflag && rsq > p.tabiklo)
+        PairSWKernel::tab_lookup(tabik_e[m], tabik_f[m], p.tabiklo, p.tabikinv,
+                                 rsq, e, de);
+      else PairSWKernel::exp_radial(sqrt(rsq), p.cutik, p.sigma_gammaik, e, de);
+    }
+  }
 };
 
 }
 
 #endif
 #endif
+
+/* ERROR/WARNING messages:
+
+E: Pair style sw/wfnho does not support rRESPA middle level
+
+The potential is split into the inner and outer levels only.
+
+E: Pair style sw/wfnho requires rRESPA inner cutoffs of 0.0
+
+The inner level is the set of bonds that no atom softens, not a
+distance range.  Use run_style respa ... inner N 0.0 0.0.
+
+*/
@@ -9,7 +9,8 @@
 ------------------------------------------------------------------------- */
 
 /* ----------------------------------------------------------------------
-   Contributing author: Axel Kohlmeyer (Temple U)
+   OpenMP version of the modified Stillinger-Weber potential (sw/wfnho)
+   Modified from the OpenMP Stillinger-Weber style by: Axel Kohlmeyer
 ------------------------------------------------------------------------- */
 
 #include <math.h>
@@ -20,17 +21,50 @@
 #include "memory.h"
 #include "neighbor.h"
 #include "neigh_list.h"
+#include "pair_sw_sort.h"
+#include "pair_sw_kernel.h"
 
 #include "suffix.h"
 using namespace LAMMPS_NS;
+using namespace PairSWSort;
+using namespace PairSWKernel;
 
 /* ---------------------------------------------------------------------- */
 
-PairSWOMP::PairSWWFNHOOMP(LAMMPS *lmp) :
+PairSWWFNHOOMP::PairSWWFNHOOMP(LAMMPS *lmp) :
   PairSWWFNHO(lmp), ThrOMP(lmp, THR_PAIR)
 {
   suffix_flag |= Suffix::OMP;
   respa_enable = 0;
+
+  nthrbound = thrinum = maxthrcost = 0;
+  thrbound = NULL;
+  thrcost = NULL;
+  nthrshort = 0;
+  maxthrshort = NULL;
+  thrshort = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+
+PairSWWFNHOOMP::~PairSWWFNHOOMP()
+{
+  memory->destroy(thrbound);
+  memory->destroy(thrcost);
+  destroy_thrshort();
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWFNHOOMP::init_style()
+{
+  PairSWWFNHO::init_style();
+  destroy_thrshort();
+
+  if (sortflag != NONE)
+    error->all(FLERR,"Pair style sw/wfnho/omp does not support the sort keyword");
+  if (tripflag)
+    error->all(FLERR,"Pair style sw/wfnho/omp does not support the triplets keyword");
 }
 
 /* ---------------------------------------------------------------------- */
@@ -45,6 +79,49 @@ void PairSWWFNHOOMP::compute(int eflag, int vflag)
   const int nthreads = comm->nthreads;
   const int inum = list->inum;
 
+  // grow coordination array if necessary
+  // need to be atom->nmax in length
+
+  if (atom->nmax > nmax) {
+    memory->destroy(coord);
+    nmax = atom->nmax;
+    memory->create(coord,nmax,"pair:coord");
+  }
+
+  // per thread ranges of the atom list with about equal estimated cost,
+  // redone when the neighbor list or the number of threads changes
+
+  const int sched = (schedflag == SCHED_COST) &&
+    (neighbor->ago == 0 || nthrbound != nthreads || thrinum != inum);
+
+  if (sched) {
+    if (inum > maxthrcost) {
+      maxthrcost = inum;
+      memory->destroy(thrcost);
+      memory->create(thrcost,maxthrcost,"pair:thrcost");
+    }
+    if (nthreads != nthrbound) {
+      nthrbound = nthreads;
+      memory->destroy(thrbound);
+      memory->create(thrbound,nthreads+1,"pair:thrbound");
+    }
+    thrinum = inum;
+  }
+
+  // per thread short lists persist across steps, add slots for new threads
+
+  if (nthreads > nthrshort) {
+    maxthrshort = (int *)
+      memory->srealloc(maxthrshort,nthreads*sizeof(int),"pair:maxthrshort");
+    thrshort = (int **)
+      memory->srealloc(thrshort,nthreads*sizeof(int *),"pair:thrshort");
+    for (int t = nthrshort; t < nthreads; t++) {
+      maxthrshort[t] = 0;
+      thrshort[t] = NULL;
+    }
+    nthrshort = nthreads;
+  }
+
 #if defined(_OPENMP)
 #pragma omp parallel default(none) shared(eflag,vflag)
 #endif
@@ -52,10 +129,41 @@ void PairSWWFNHOOMP::compute(int eflag, int vflag)
     int ifrom, ito, tid;
 
     loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+
+    if (sched) {
+      cost_thr(ifrom, ito);
+      sync_threads();
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+      { cost_partition(inum, thrcost, nthreads, thrbound); }
+      sync_threads();
+    }
+    if (schedflag == SCHED_COST) {
+      ifrom = thrbound[tid];
+      ito = thrbound[tid+1];
+    }
+
     ThrData *thr = fix->get_thr(tid);
     thr->timer(Timer::START);
     ev_setup_thr(eflag, vflag, nall, eatom, vatom, thr);
 
+    // each thread only writes the coordination of its own atoms,
+    // but the pair loop reads those of all atoms, so wait for all threads
+
+    coord_thr(ifrom, ito);
+    sync_threads();
+
+    // communicate coordination numbers of ghost atoms
+    // on the master thread and wait until it is done
+
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+    { comm->forward_comm_pair(this); }
+
+    sync_threads();
+
     if (evflag) {
       if (eflag) {
         eval<1,1>(ifrom, ito, thr);
@@ -69,57 +177,103 @@ void PairSWWFNHOOMP::compute(int eflag, int vflag)
   } // end of omp parallel region
 }
 
-template <int EVFLAG, int EFLAG>
-void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
-{
-  int i,j,k,ii,jj,kk,jnum,jnumm1,maxshort_thr;
-  tagint itag,jtag;
-  int itype,jtype,ktype,ijparam,ikparam,ijkparam;
-  double xtmp,ytmp,ztmp,delx,dely,delz,evdwl,fpair;
-  double rsq,rsq1,rsq2, bigr, bigd, gij, r;
-  double delr1[3],delr2[3],fj[3],fk[3];
-  int *ilist,*jlist,*numneigh,**firstneigh,*neighshort_thr;
+/* ----------------------------------------------------------------------
+   estimated cost of atom list entries ifrom to ito-1
+------------------------------------------------------------------------- */
 
-  evdwl = 0.0;
+void PairSWWFNHOOMP::cost_thr(int iifrom, int iito)
+{
+  int i,j,ii,jj,jnum,itype,jtype,nshort;
+  double delx,dely,delz,rsq;
+  int *ilist,*jlist,*numneigh,**firstneigh;
 
   const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
-  dbl3_t * _noalias const f = (dbl3_t *) thr->get_f()[0];
-  const tagint * _noalias const tag = atom->tag;
   const int * _noalias const type = atom->type;
-  const int nlocal = atom->nlocal;
 
   ilist = list->ilist;
   numneigh = list->numneigh;
   firstneigh = list->firstneigh;
-  maxshort_thr = maxshort;
-  memory->create(neighshort_thr,maxshort_thr,"pair_thr:neighshort_thr");
 
-  double fxtmp,fytmp,fztmp;
-  
-  // calculate coordination number for softening function
-  
   for (ii = iifrom; ii < iito; ++ii) {
     i = ilist[ii];
-    coord[tag[i]] = 0;
+    itype = map[type[i]];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+    nshort = 0;
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      j &= NEIGHMASK;
+      delx = x[i].x - x[j].x;
+      dely = x[i].y - x[j].y;
+      delz = x[i].z - x[j].z;
+      rsq = delx*delx + dely*dely + delz*delz;
+      jtype = map[type[j]];
+      if (rsq < cutshortsq[itype][jtype]) nshort++;
+    }
+    thrcost[ii] = atom_cost(jnum,nshort);
   }
+}
+
+/* ----------------------------------------------------------------------
+   make the short list of thread tid hold at least n neighbors, rounded
+   up to whole cache lines so lists of different threads share none.
+   called by that thread only, before the list is filled
+------------------------------------------------------------------------- */
+
+void PairSWWFNHOOMP::grow_thrshort(int tid, int n)
+{
+  n = (n + 15) & ~15;
+  memory->destroy(thrshort[tid]);
+  memory->create(thrshort[tid],n,"pair:thrshort");
+  maxthrshort[tid] = n;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWFNHOOMP::destroy_thrshort()
+{
+  for (int t = 0; t < nthrshort; t++) memory->destroy(thrshort[t]);
+  memory->sfree(maxthrshort);
+  memory->sfree(thrshort);
+  nthrshort = 0;
+  maxthrshort = NULL;
+  thrshort = NULL;
+}
+
+/* ----------------------------------------------------------------------
+   coordination number for softening function of atoms ifrom to ito-1
+------------------------------------------------------------------------- */
+
+void PairSWWFNHOOMP::coord_thr(int iifrom, int iito)
+{
+  int i,j,ii,jj,jnum,itype,jtype,ijparam;
+  double xtmp,ytmp,ztmp,delx,dely,delz,rsq,r,bigr,bigd,dfc,ctmp;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  const int * _noalias const type = atom->type;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
 
   for (ii = iifrom; ii < iito; ++ii) {
     i = ilist[ii];
-    itag = tag[i];
     itype = map[type[i]];
     xtmp = x[i].x;
     ytmp = x[i].y;
     ztmp = x[i].z;
-    
+    ctmp = 0.0;
+
     jlist = firstneigh[i];
     jnum = numneigh[i];
+
     for (jj = 0; jj < jnum; jj++) {
-      j=jlist[jj];
-	  j &= NEIGHMASK;
-	  
-      jtag = tag[j];
+      j = jlist[jj];
+      j &= NEIGHMASK;
       jtype = map[type[j]];
-      
+
       if (softflag[itype][jtype]) {
         ijparam = elem2param[itype][jtype][jtype];
         bigr = soft[elem2soft[itype][jtype]].bigr;
@@ -129,13 +283,44 @@ void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
         delz = ztmp - x[j].z;
         rsq = delx*delx + dely*dely + delz*delz;
         r = sqrt(rsq) / params[ijparam].sigma;
-        
-        if (r < (bigr - bigd)) coord[itag] += 1;
+
+        if (r < (bigr - bigd)) ctmp += 1;
         else if (r < (bigr + bigd))
-          coord[itag] += 1 - (r-bigr+bigd)/(2*bigd) + sin(PIVAL*(r-bigr+bigd)/bigd)/(2*PIVAL);
+          ctmp += soft_fc<0>(r-bigr+bigd, PIVAL/bigd, 0.5/bigd, dfc);
       }
     }
+    coord[i] = ctmp;
   }
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG>
+void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
+{
+  int i,j,k,ii,jj,kk,jnum,jnumm1;
+  tagint itag,jtag;
+  int itype,jtype,ktype,ijparam,ijkparam;
+  double xtmp,ytmp,ztmp,delx,dely,delz,evdwl,fpair;
+  double rsq,rsq1,rsq2,gij;
+  double delr1[3],delr2[3],fj[3],fk[3];
+  int *ilist,*jlist,*numneigh,**firstneigh,*neighshort_thr;
+
+  evdwl = 0.0;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  dbl3_t * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  const tagint * _noalias const tag = atom->tag;
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+  const int tid = thr->get_tid();
+  neighshort_thr = thrshort[tid];
+
+  double fxtmp,fytmp,fztmp;
 
   // loop over full neighbor list of my atoms
 
@@ -154,26 +339,23 @@ void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
     jlist = firstneigh[i];
     jnum = numneigh[i];
     int numshort = 0;
+    if (jnum > maxthrshort[tid]) {
+      grow_thrshort(tid,jnum);
+      neighshort_thr = thrshort[tid];
+    }
 
     for (jj = 0; jj < jnum; jj++) {
       j = jlist[jj];
       j &= NEIGHMASK;
+      jtype = map[type[j]];
 
       delx = xtmp - x[j].x;
       dely = ytmp - x[j].y;
       delz = ztmp - x[j].z;
       rsq = delx*delx + dely*dely + delz*delz;
 
-      jtype = map[type[j]];
-      ijparam = elem2param[itype][jtype][jtype];
-      if (rsq >= params[ijparam].cutsq) {
-        continue;
-      } else {
+      if (rsq < cutshortsq[itype][jtype]) {
         neighshort_thr[numshort++] = j;
-        if (numshort >= maxshort_thr) {
-          maxshort_thr += maxshort_thr/2;
-          memory->grow(neighshort_thr,maxshort_thr,"pair:neighshort_thr");
-        }
       }
 
       jtag = tag[j];
@@ -187,15 +369,18 @@ void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
         if (x[j].z == ztmp && x[j].y == ytmp && x[j].x < xtmp) continue;
       }
 
+      ijparam = elem2param[itype][jtype][jtype];
+      if (rsq > params[ijparam].cutpairsq) continue;
+
       twobody(&params[ijparam],rsq,fpair,EFLAG,evdwl);
-	  
-	  if (softflag[itype][jtype]) 
-        gij = gsoft(coord[itag], itype, jtype);
-      else if (softflag[jtype][itype]) 
-        gij = gsoft(coord[jtag], jtype, itype);
+
+      if (softflag[itype][jtype])
+        gij = gsoft(coord[i],itype,jtype);
+      else if (softflag[jtype][itype])
+        gij = gsoft(coord[j],jtype,itype);
       else
         gij = 1;
-  
+
       evdwl = gij * evdwl;
       fpair = gij * fpair;
 
@@ -215,7 +400,6 @@ void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
     for (jj = 0; jj < jnumm1; jj++) {
       j = neighshort_thr[jj];
       jtype = map[type[j]];
-      ijparam = elem2param[itype][jtype][jtype];
       delr1[0] = x[j].x - xtmp;
       delr1[1] = x[j].y - ytmp;
       delr1[2] = x[j].z - ztmp;
@@ -227,19 +411,18 @@ void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
       for (kk = jj+1; kk < numshort; kk++) {
         k = neighshort_thr[kk];
         ktype = map[type[k]];
-        ikparam = elem2param[itype][ktype][ktype];
         ijkparam = elem2param[itype][jtype][ktype];
-		
-		if (rsq1 > params[ijkparam].cutijsq) continue;
+
+        if (rsq1 > params[ijkparam].cutijsq) continue;
 
         delr2[0] = x[k].x - xtmp;
         delr2[1] = x[k].y - ytmp;
         delr2[2] = x[k].z - ztmp;
         rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
-		
-		if (rsq2 > params[ijkparam].cutiksq) continue;
 
-        threebody(&params[ijkparam], rsq1, rsq2, delr1, delr2, fj, fk, eflag, evdwl);
+        if (rsq2 > params[ijkparam].cutiksq) continue;
+
+        threebody(&params[ijkparam],rsq1,rsq2,delr1,delr2,fj,fk,EFLAG,evdwl);
 
         fxtmp -= fj[0] + fk[0];
         fytmp -= fj[1] + fk[1];
@@ -261,7 +444,6 @@ void PairSWWFNHOOMP::eval(int iifrom, int iito, ThrData * const thr)
     f[i].y += fytmp;
     f[i].z += fztmp;
   }
-  memory->destroy(neighshort_thr);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -270,6 +452,9 @@ double PairSWWFNHOOMP::memory_usage()
 {
   double bytes = memory_usage_thr();
   bytes += PairSWWFNHO::memory_usage();
+  bytes += maxthrcost * sizeof(double);
+  bytes += nthrbound * sizeof(int);
+  for (int t = 0; t < nthrshort; t++) bytes += maxthrshort[t] * sizeof(int);
 
   return bytes;
 }
@@ -12,7 +12,8 @@
 ------------------------------------------------------------------------- */
 
 /* ----------------------------------------------------------------------
-   Contributing author: Axel Kohlmeyer (Temple U)
+   OpenMP version of the modified Stillinger-Weber potential (sw/wfnho)
+   Modified from the OpenMP Stillinger-Weber style by: Axel Kohlmeyer
 ------------------------------------------------------------------------- */
 
 #ifdef PAIR_CLASS
@@ -33,11 +34,28 @@ class PairSWWFNHOOMP : public PairSWWFNHO, public ThrOMP {
 
  public:
   PairSWWFNHOOMP(class LAMMPS *);
+  virtual ~PairSWWFNHOOMP();
 
   virtual void compute(int, int);
+  virtual void init_style();
   virtual double memory_usage();
 
  private:
+  int nthrbound;                // # of threads the ranges are made for
+  int thrinum;                  // # of atoms the ranges are made for
+  int *thrbound;                // first atom list entry of each thread
+  int maxthrcost;               // size of thrcost
+  double *thrcost;              // estimated cost of each atom list entry
+  int nthrshort;                // # of threads with a short list
+  int *maxthrshort;             // size of the short list of each thread
+  int **thrshort;               // short neighbor list of each thread
+
+  void cost_thr(int ifrom, int ito);
+  void grow_thrshort(int tid, int n);
+  void destroy_thrshort();
+
+  void coord_thr(int ifrom, int ito);
+
   template <int EVFLAG, int EFLAG>
   void eval(int ifrom, int ito, ThrData * const thr);
 };
@@ -46,3 +64,16 @@ class PairSWWFNHOOMP : public PairSWWFNHO, public ThrOMP {
 
 #endif
 #endif
+
+/* ERROR/WARNING messages:
+
+E: Pair style sw/wfnho/omp does not support the sort keyword
+
+The threaded kernels keep the neighbor order of the short lists.
+
+E: Pair style sw/wfnho/omp does not support the triplets keyword
+
+The threaded kernels evaluate the three-body terms from the short
+neighbor lists of every step and do not cache triplets.
+
+*/
@@ -25,6 +25,8 @@
 #include "stdlib.h"
 #include "string.h"
 #include "pair_sw_woo.h"
+#include "pair_sw_sort.h"
+#include "pair_sw_kernel.h"
 #include "atom.h"
 #include "neighbor.h"
 #include "neigh_request.h"
@@ -34,12 +36,35 @@
 #include "neighbor.h"
 #include "neigh_list.h"
 #include "memory.h"
+#include "update.h"
+#include "respa.h"
 #include "error.h"
+#include "suffix.h"
 
 using namespace LAMMPS_NS;
+using namespace PairSWSort;
+using namespace PairSWKernel;
 
 #define MAXLINE 1024
 #define DELTA 4
+#define TABINNER 0.5     // inner end of the tables in units of sigma
+#define TABTOL 1.0e-4    // warn if measured table error is larger
+#define TABFLOOR 1.0e-3  // table errors are relative to at least this
+                         // fraction of the largest scale beyond sigma
+#define NFASTFC 256      // fastmath intervals of the cutoff function
+#define FASTZMAX 16.0    // end of the fastmath g(Z) tables
+#define FASTZSTEP 64     // fastmath g(Z) intervals per unit Z
+
+// rows of the SoA block used by the vectorized three-body kernel
+
+enum{KDELX,KDELY,KDELZ,KRSQ,KEXP1,KDEXP1,KEXP2,KDEXP2,
+     KFJX,KFJY,KFJZ,KFKX,KFKY,KFKZ,KENG,NKBUF};
+
+// rows of the per short neighbor cache, the radial factors follow
+// RRAD with REXPJ..RDEXPK for each element of the other leg
+
+enum{RDELX,RDELY,RDELZ,RRSQ,RRAD};
+enum{REXPJ,RDEXPJ,REXPK,RDEXPK,NRAD};
 
 /* ---------------------------------------------------------------------- */
 
@@ -47,6 +72,7 @@ PairSWWOO::PairSWWOO(LAMMPS *lmp) : Pair(lmp)
 {
   single_enable = 0;
   one_coeff = 1;
+  respa_enable = 1;
   nelements = 0;
   elements = NULL;
   nparams = maxparam = 0;
@@ -55,6 +81,60 @@ PairSWWOO::PairSWWOO(LAMMPS *lmp) : Pair(lmp)
   elem2param = NULL;
   soft = NULL;
   elem2soft = NULL;
+  e2p = NULL;
+  pairparam = NULL;
+  nelemspec = softspec = 0;
+  cutshortsq = NULL;
+
+  maxshort = 10;
+  neighshort = NULL;
+  kbuf = NULL;
+  kbuf_single = NULL;
+  kneigh = kparam = NULL;
+  shortrad = NULL;
+  shortrsq = sortrsq = NULL;
+  shortelem = shortend = sortneigh = shortfirst = NULL;
+  sortflag = NONE;
+  tripflag = 0;
+  schedflag = SCHED_COST;
+  ntrip = maxtrip = nleg = maxleg = 0;
+  trip = NULL;
+  tripbuild = -1;
+  leg = NULL;
+  legbuf = NULL;
+  legmap = NULL;
+  precision = PREC_DOUBLE;
+
+  tabflag = ntable = 0;
+  tabpair_e = tabpair_f = NULL;
+  tabij_e = tabij_f = tabik_e = tabik_f = NULL;
+  fastflag = 0;
+  fastfc = NULL;
+  fastg = NULL;
+  fastzmax = fastzscale = 0.0;
+
+  // coordination numbers are stored per local and ghost atom
+  // ghost values are filled in by forward communication
+
+  comm_forward = 1;
+  nmax = 0;
+  coord = NULL;
+  numhalf = NULL;
+  halfbuild = -1;
+  atomwork = NULL;
+
+  // dE/dZ of ghost atoms is summed back to the owners by reverse communication
+
+  comm_reverse = 1;
+  dedz = NULL;
+  gcn = NULL;
+  softfirst = softnum = NULL;
+  maxsoft = 0;
+  softneigh = NULL;
+  softdfc = NULL;
+  fused = 0;
+  maxdefer = 0;
+  defer = NULL;
 }
 
 /* ----------------------------------------------------------------------
@@ -63,136 +143,387 @@ PairSWWOO::PairSWWOO(LAMMPS *lmp) : Pair(lmp)
 
 PairSWWOO::~PairSWWOO()
 {
+  if (copymode) return;
+
   if (elements)
     for (int i = 0; i < nelements; i++) delete [] elements[i];
   delete [] elements;
   memory->destroy(params);
   memory->destroy(soft);
   memory->destroy(elem2param);
+  memory->destroy(elem2soft);
+  memory->destroy(e2p);
+  memory->sfree(pairparam);
+  memory->destroy(cutshortsq);
+  memory->destroy(shortfirst);
+  memory->destroy(tabpair_e);
+  memory->destroy(tabpair_f);
+  memory->destroy(tabij_e);
+  memory->destroy(tabij_f);
+  memory->destroy(tabik_e);
+  memory->destroy(tabik_f);
+  memory->destroy(fastfc);
+  memory->destroy(fastg);
+  memory->destroy(coord);
+  memory->destroy(numhalf);
+  memory->destroy(atomwork);
+  memory->destroy(dedz);
+  memory->destroy(gcn);
+  memory->destroy(softfirst);
+  memory->destroy(softnum);
+  memory->destroy(softneigh);
+  memory->destroy(softdfc);
+  memory->sfree(defer);
+  memory->sfree(trip);
+  memory->sfree(leg);
+  memory->destroy(legbuf);
   
   if (allocated) {
     memory->destroy(setflag);
     memory->destroy(softflag);
     memory->destroy(cutsq);
+    memory->destroy(neighshort);
+    memory->destroy(kbuf);
+    memory->destroy(kbuf_single);
+    memory->destroy(kneigh);
+    memory->destroy(kparam);
+    memory->destroy(shortrad);
+    memory->destroy(shortrsq);
+    memory->destroy(shortelem);
+    memory->destroy(shortend);
+    memory->destroy(sortneigh);
+    memory->destroy(sortrsq);
+    memory->destroy(legmap);
     delete [] map;
-    delete [] coord;
   }
 }
 
 /* ---------------------------------------------------------------------- */
 void PairSWWOO::compute(int eflag, int vflag)
 {
-  int i, j, k, ii, jj, kk, inum, jnum, knum, jnumm1, itag, jtag, ktag;
-  int itype, jtype, ktype, ijparam, ijkparam;
-  double xtmp, ytmp, ztmp, delx, dely, delz, evdwl, fpair;
-  double rsq, rsq1, rsq2, bigr, bigd, gij, r;
-  double dgij,dfcik;
-  double delr1[3], delr2[3], fj[3], fk[3];
-  int *ilist, *jlist, *klist, *numneigh, **firstneigh;
-  
-  evdwl = 0.0;
   if (eflag || vflag) ev_setup(eflag, vflag);
   else evflag = vflag_fdotr = 0;
-  
+
+  eval_terms(eflag, 0);
+
+  if (vflag_fdotr) virial_fdotr_compute();
+}
+
+/* ----------------------------------------------------------------------
+   rRESPA inner level: pair terms of the bonds that no atom softens.
+   they depend on the distance only and are the stiffest forces.
+   softened bonds depend on the coordination numbers and are left to
+   the outer level, so for a mostly softened system, e.g. the Si-O
+   bonds of SiO2, the inner level holds little and rRESPA gains little
+------------------------------------------------------------------------- */
+
+void PairSWWOO::compute_inner()
+{
+  grow_peratom();
+  half_split(this);
+  pair_inner();
+}
+
+/* ----------------------------------------------------------------------
+   rRESPA outer level: softened pair terms, coordination forces and
+   three-body terms, i.e. everything but the inner level. energy and
+   virial are those of the whole potential, as with pairwise styles
+------------------------------------------------------------------------- */
+
+void PairSWWOO::compute_outer(int eflag, int vflag)
+{
+  if (eflag || vflag) ev_setup(eflag, vflag);
+  else evflag = vflag_fdotr = 0;
+
+  eval_terms(eflag, 1);
+
+  if (vflag_fdotr) virial_fdotr_compute();
+}
+
+/* ----------------------------------------------------------------------
+   all terms of the potential, outer = 1 leaves out the forces of the
+   unsoftened pair terms and only tallies their energy and virial
+------------------------------------------------------------------------- */
+
+void PairSWWOO::eval_terms(int eflag, int outer)
+{
+  // grow coordination arrays if necessary
+  // need to be atom->nmax in length
+
+  grow_peratom();
+
+  // work counts of local atoms are those of the current step
+
+  const int nlocal = atom->nlocal;
+  for (int i = 0; i < nlocal; i++)
+    atomwork[i][WNEIGH] = atomwork[i][WTRIP] = atomwork[i][WSOFT] = 0.0;
+
+  // owned neighbors first in each list, redone when the list is rebuilt
+
+  half_split(this);
+
+  // kernels specialized for one or two elements and for the absence
+  // of softening, as selected in init_style(). with softening, the
+  // fused kernel does a single sweep over the neighbor list instead of
+  // a coordination pass followed by the pair pass
+
+  if (nelemspec == 1) {
+    if (softspec && fused) eval_fused<1>(eflag, outer);
+    else if (softspec) eval<1,1>(eflag, outer);
+    else eval<1,0>(eflag, outer);
+  } else if (nelemspec == 2) {
+    if (softspec && fused) eval_fused<2>(eflag, outer);
+    else if (softspec) eval<2,1>(eflag, outer);
+    else eval<2,0>(eflag, outer);
+  } else {
+    if (softspec && fused) eval_fused<0>(eflag, outer);
+    else if (softspec) eval<0,1>(eflag, outer);
+    else eval<0,0>(eflag, outer);
+  }
+
+  if (tripflag) {
+    if (tripbuild != neighbor->ncalls) build_triplets(this);
+    eval_triplets(this, eflag);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   add the forces of the unsoftened pair terms, no tallies
+------------------------------------------------------------------------- */
+
+void PairSWWOO::pair_inner()
+{
+  int i, j, ii, jj, inum, jhalf, itype, jtype, ijparam;
+  double xtmp, ytmp, ztmp, delx, dely, delz, rsq, fpair, evdwl;
+  int *ilist, *jlist, **firstneigh;
+
   double **x = atom->x;
   double **f = atom->f;
-  int *tag = atom->tag;
   int *type = atom->type;
-  int nlocal = atom->nlocal;
-  int newton_pair = force->newton_pair;
 
   inum = list->inum;
   ilist = list->ilist;
-  numneigh = list->numneigh;
   firstneigh = list->firstneigh;
 
-  // calculate coordination number for softening function
-  for (ii = 0; ii < inum; ii++) {
-    i = ilist[ii];
-    coord[tag[i]] = 0;
-  }
-
   for (ii = 0; ii < inum; ii++) {
     i = ilist[ii];
-    itag = tag[i];
     itype = map[type[i]];
     xtmp = x[i][0];
     ytmp = x[i][1];
     ztmp = x[i][2];
-    
+
     jlist = firstneigh[i];
-    jnum = numneigh[i];
-    for (jj = 0; jj < jnum; jj++) {
-      j=jlist[jj];
-      jtag = tag[j];
+    jhalf = numhalf[i];
+
+    for (jj = 0; jj < jhalf; jj++) {
+      j = jlist[jj];
       jtype = map[type[j]];
-      
-      if (softflag[itype][jtype]) {
-        ijparam = elem2param[itype][jtype][jtype];
-        bigr = soft[elem2soft[itype][jtype]].bigr;
-        bigd = soft[elem2soft[itype][jtype]].bigd;
+      const PairParam &pp = pairparam[itype*nelements + jtype];
+      if (pp.isoft >= 0 || pairparam[jtype*nelements + itype].isoft >= 0)
+        continue;
+      ijparam = pp.ijparam;
+
+      delx = xtmp - x[j][0];
+      dely = ytmp - x[j][1];
+      delz = ztmp - x[j][2];
+      rsq = delx*delx + dely*dely + delz*delz;
+      if (rsq > params[ijparam].cutpairsq) continue;
+
+      twobody(&params[ijparam], rsq, fpair, 0, evdwl);
+
+      f[i][0] += delx * fpair;
+      f[i][1] += dely * fpair;
+      f[i][2] += delz * fpair;
+      f[j][0] -= delx * fpair;
+      f[j][1] -= dely * fpair;
+      f[j][2] -= delz * fpair;
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   grow per-atom arrays to atom->nmax
+------------------------------------------------------------------------- */
+
+void PairSWWOO::grow_peratom()
+{
+  if (atom->nmax <= nmax) return;
+
+  memory->destroy(coord);
+  memory->destroy(numhalf);
+  memory->destroy(atomwork);
+  memory->destroy(dedz);
+  memory->destroy(gcn);
+  memory->destroy(softfirst);
+  memory->destroy(softnum);
+  nmax = atom->nmax;
+  memory->create(coord, nmax, "pair:coord");
+  memory->create(numhalf, nmax, "pair:numhalf");
+  memory->create(atomwork, nmax, NWORK, "pair:atomwork");
+  memory->create(dedz, nmax, "pair:dedz");
+  memory->create(gcn, nmax, 2*nelements, "pair:gcn");
+  memory->create(softfirst, nmax, "pair:softfirst");
+  memory->create(softnum, nmax, "pair:softnum");
+}
+
+/* ----------------------------------------------------------------------
+   NELEM = # of elements if 1 or 2, 0 for any number
+   SOFTFLAG = 0 if no bond of the potential is softened
+------------------------------------------------------------------------- */
+
+template <int NELEM, int SOFTFLAG>
+void PairSWWOO::eval(int eflag, int outer)
+{
+  int i, j, ii, jj, inum, jnum, numshort, jhalf, nsoftpair;
+  int itype, jtype, ijparam;
+  int nall, nsoft;
+  double xtmp, ytmp, ztmp, delx, dely, delz, evdwl, fpair;
+  double rsq, gij, r, rs, dfc;
+  int *ilist, *jlist, *numneigh, **firstneigh;
+
+  evdwl = 0.0;
+
+  double **x = atom->x;
+  double **f = atom->f;
+  int *type = atom->type;
+  int nlocal = atom->nlocal;
+  int newton_pair = force->newton_pair;
+
+  inum = list->inum;
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  // calculate coordination number for softening function
+  // store neighbors inside the transition zone of the cutoff function
+  // together with dfc/(sigma*r), which is all the force pass needs
+
+  if (SOFTFLAG) {
+    nsoft = 0;
+    for (ii = 0; ii < inum; ii++) {
+      i = ilist[ii];
+      itype = elem<NELEM>(type[i]);
+      xtmp = x[i][0];
+      ytmp = x[i][1];
+      ztmp = x[i][2];
+    
+      jlist = firstneigh[i];
+      jnum = numneigh[i];
+      coord[i] = 0;
+
+      if (nsoft + jnum > maxsoft) {
+        maxsoft = nsoft + jnum + maxsoft/2;
+        memory->grow(softneigh, maxsoft, "pair:softneigh");
+        memory->grow(softdfc, maxsoft, "pair:softdfc");
+      }
+      softfirst[i] = nsoft;
+
+      for (jj = 0; jj < jnum; jj++) {
+        j = jlist[jj];
+        jtype = elem<NELEM>(type[j]);
+        const PairParam &pp = pairparam[pairindex<NELEM>(itype,jtype)];
+        if (pp.isoft < 0) continue;
+
         delx = xtmp - x[j][0];
         dely = ytmp - x[j][1];
         delz = ztmp - x[j][2];
         rsq = delx*delx + dely*dely + delz*delz;
-        r = sqrt(rsq) / params[ijparam].sigma;
-        
-        if (r < (bigr - bigd)) coord[itag] += 1;
-        else if (r < (bigr + bigd))
-          coord[itag] += 1 - (r-bigr+bigd)/(2*bigd) + sin(PIVAL*(r-bigr+bigd)/bigd)/(2*PIVAL);
+
+        if (rsq < pp.softlosq) coord[i] += 1;
+        else if (rsq < pp.softhisq) {
+          rs = sqrt(rsq);
+          r = rs * pp.sigmainv - pp.softlo;
+          coord[i] += soft_cut(r, pp, dfc);
+          softneigh[nsoft] = j;
+          softdfc[nsoft++] = dfc * pp.sigmainv / rs;
+        }
       }
+      softnum[i] = nsoft - softfirst[i];
+      soften(i, itype);
     }
+
+    // communicate coordination numbers and softening of ghost atoms
+
+    comm->forward_comm_pair(this);
+
+    // zero dE/dZ accumulators of local and ghost atoms
+
+    nall = nlocal + atom->nghost;
+    for (i = 0; i < nall; i++) dedz[i] = 0.0;
   }
 
   // loop over full neighbor list of my atoms
 
   for (ii = 0; ii < inum; ii++) {
     i = ilist[ii];
-    itag = tag[i];
-    itype = map[type[i]];
+    itype = elem<NELEM>(type[i]);
     xtmp = x[i][0];
     ytmp = x[i][1];
     ztmp = x[i][2];
 
-    // two-body interactions, skip half of them
+    // two-body interactions of the owned neighbors at the front of the list
 
     jlist = firstneigh[i];
     jnum = numneigh[i];
+    jhalf = numhalf[i];
+
+    numshort = nsoftpair = 0;
 
     for (jj = 0; jj < jnum; jj++) {
       j = jlist[jj];
-      jtag = tag[j];
-
-      if (itag > jtag) {
-         if ((itag+jtag) % 2 == 0) continue;
-      } 
-      else if (itag < jtag) {
-         if ((itag+jtag) % 2 == 1) continue;
-      }
-      else {
-        if (x[j][2] < ztmp) continue;
-        if (x[j][2] == ztmp && x[j][1] < ytmp) continue;
-        if (x[j][2] == ztmp && x[j][1] == ytmp && x[j][0] < xtmp) continue;
-      }
-
-      jtype = map[type[j]];
+      jtype = elem<NELEM>(type[j]);
  
       delx = xtmp - x[j][0];
       dely = ytmp - x[j][1];
       delz = ztmp - x[j][2];
       rsq = delx*delx + dely*dely + delz*delz;
+
+      // short list of neighbors that can take part in a three-body term
+
+      const PairParam &pp = pairparam[pairindex<NELEM>(itype,jtype)];
+
+      if (rsq < pp.cutshortsq) {
+        shortrsq[numshort] = rsq;
+        shortelem[numshort] = jtype;
+        neighshort[numshort++] = j;
+        if (numshort >= maxshort) {
+          maxshort += maxshort/2;
+          grow_short();
+        }
+      }
+
+      if (jj >= jhalf) continue;
   
-      ijparam = elem2param[itype][jtype][jtype];
-      if (rsq > params[ijparam].cutpairsq) continue;
-  
-      twobody(&params[ijparam], rsq, fpair, eflag, evdwl);
+      if (rsq > pp.cutpairsq) continue;
+      ijparam = pp.ijparam;
   
-      if (softflag[itype][jtype]) 
-        gij = gsoft(coord[itag], itype, jtype);
-      else if (softflag[jtype][itype]) 
-        gij = gsoft(coord[jtag], jtype, itype);
-      else
+      // softened pairs always need the bare pair energy,
+      // it enters dE/dZ of the atom whose coordination softens the bond
+
+      if (SOFTFLAG && pp.isoft >= 0) {
+        twobody(&params[ijparam], rsq, fpair, 1, evdwl);
+        gij = gcn[i][2*jtype];
+        dedz[i] += gcn[i][2*jtype+1] * evdwl;
+        nsoftpair++;
+      }
+      else if (SOFTFLAG && pairparam[pairindex<NELEM>(jtype,itype)].isoft >= 0) {
+        twobody(&params[ijparam], rsq, fpair, 1, evdwl);
+        gij = gcn[j][2*itype];
+        dedz[j] += gcn[j][2*itype+1] * evdwl;
+        nsoftpair++;
+      }
+      else {
+        // unsoftened pairs are the rRESPA inner level, the outer level
+        // only tallies their energy and virial
+        if (outer && !evflag) continue;
+        twobody(&params[ijparam], rsq, fpair, eflag, evdwl);
+        if (outer) {
+          ev_tally(i, j, nlocal, newton_pair, evdwl, 0.0, fpair,
+                   delx, dely, delz);
+          continue;
+        }
         gij = 1;
+      }
   
       evdwl = gij * evdwl;
       fpair = gij * fpair;
@@ -206,156 +537,291 @@ void PairSWWOO::compute(int eflag, int vflag)
       
       if (evflag) 
         ev_tally(i, j, nlocal, newton_pair, evdwl, 0.0, fpair, delx, dely, delz);
+    }
 
-      if (softflag[itype][jtype]) {
-        dgij = dgsoft(coord[itag], itype, jtype);
-        for (kk = 0; kk < jnum; kk++) {
-          k = jlist[kk];
-          ktag = tag[k];
-          ktype = map[type[k]];
-          if (softflag[itype][ktype]) {
-            ijparam = elem2param[itype][ktype][ktype];
-            bigr = soft[elem2soft[itype][ktype]].bigr;
-            bigd = soft[elem2soft[itype][ktype]].bigd;
-            delx = x[i][0] - x[k][0];
-            dely = x[i][1] - x[k][1];
-            delz = x[i][2] - x[k][2];
-            rsq = delx*delx + dely*dely + delz*delz;
-            r = sqrt(rsq) / params[ijparam].sigma;
-
-            if (r > (bigr - bigd) && r < (bigr + bigd))
-              dfcik = - 0.5/bigd + cos(PIVAL*(r-bigr+bigd)/bigd)/(2*bigd);
-              //dfcik = 1 - (r-bigr+bigd)/(2*bigd) + sin(PIVAL*(r-bigr+bigd)/bigd)/(2*PIVAL);
-            else
-              dfcik = 0;
-
-            evdwl = evdwl / gij;
-            fpair = dgij * dfcik * evdwl / r;
-            f[i][0] -= delx * fpair;
-            f[i][1] -= dely * fpair;
-            f[i][2] -= delz * fpair;
-            f[k][0] += delx * fpair;
-            f[k][1] += dely * fpair;
-            f[k][2] += delz * fpair;
-            if (evflag) 
-              ev_tally(i, k, nlocal, newton_pair, 0.0, 0.0, fpair, delx, dely, delz);
-          }
+    atomwork[i][WNEIGH] = jnum + 0.5*numshort*(numshort-1);
+    atomwork[i][WSOFT] = nsoftpair;
+
+    // three-body interactions of all pairs of short neighbors,
+    // unless they come from the cached triplet list
+
+    if (tripflag) continue;
+    if (precision == PREC_DOUBLE)
+      eval_threebody<NELEM,double,double>(i, itype, numshort, eflag);
+    else if (precision == PREC_MIXED)
+      eval_threebody<NELEM,float,double>(i, itype, numshort, eflag);
+    else
+      eval_threebody<NELEM,float,float>(i, itype, numshort, eflag);
+  }
+
+  if (SOFTFLAG) dsoft();
+}
+
+/* ----------------------------------------------------------------------
+   single sweep over the full neighbor list for potentials with softening.
+   the coordination number, short list, bare pair terms and three-body
+   terms of atom I are all computed while its neighbors are at hand.
+   softened pairs are deferred with their bare energy and force until
+   g(Z) of the softened atom, possibly a ghost, is known
+------------------------------------------------------------------------- */
+
+template <int NELEM>
+void PairSWWOO::eval_fused(int eflag, int outer)
+{
+  int i, j, ii, jj, inum, jnum, numshort, jhalf, nsoftpair;
+  int itype, jtype, ijparam, nsoft, ndefer, nall, side;
+  double xtmp, ytmp, ztmp, delx, dely, delz, evdwl, fpair;
+  double rsq, r, rs, dfc, ctmp, gij;
+  int *ilist, *jlist, *numneigh, **firstneigh;
+
+  evdwl = 0.0;
+
+  double **x = atom->x;
+  double **f = atom->f;
+  int *type = atom->type;
+  int nlocal = atom->nlocal;
+  int newton_pair = force->newton_pair;
+
+  inum = list->inum;
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  nsoft = ndefer = 0;
+  for (ii = 0; ii < inum; ii++) {
+    i = ilist[ii];
+    itype = elem<NELEM>(type[i]);
+    xtmp = x[i][0];
+    ytmp = x[i][1];
+    ztmp = x[i][2];
+
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+    jhalf = numhalf[i];
+
+    if (nsoft + jnum > maxsoft) {
+      maxsoft = nsoft + jnum + maxsoft/2;
+      memory->grow(softneigh, maxsoft, "pair:softneigh");
+      memory->grow(softdfc, maxsoft, "pair:softdfc");
+    }
+    if (ndefer + jnum > maxdefer) {
+      maxdefer = ndefer + jnum + maxdefer/2;
+      defer = (DeferPair *)
+        memory->srealloc(defer, maxdefer*sizeof(DeferPair), "pair:defer");
+    }
+    softfirst[i] = nsoft;
+    ctmp = 0.0;
+    numshort = nsoftpair = 0;
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      jtype = elem<NELEM>(type[j]);
+
+      delx = xtmp - x[j][0];
+      dely = ytmp - x[j][1];
+      delz = ztmp - x[j][2];
+      rsq = delx*delx + dely*dely + delz*delz;
+
+      const PairParam &pp = pairparam[pairindex<NELEM>(itype,jtype)];
+
+      // coordination number and transition-zone neighbors
+
+      if (pp.isoft >= 0) {
+        if (rsq < pp.softlosq) ctmp += 1;
+        else if (rsq < pp.softhisq) {
+          rs = sqrt(rsq);
+          r = rs * pp.sigmainv - pp.softlo;
+          ctmp += soft_cut(r, pp, dfc);
+          softneigh[nsoft] = j;
+          softdfc[nsoft++] = dfc * pp.sigmainv / rs;
         }
       }
-      else if (softflag[jtype][itype]) {
-        dgij = dgsoft(coord[jtag], jtype, itype);
-        klist = firstneigh[j];
-        knum = numneigh[j];
-        for (kk = 0; kk < knum; kk++) {
-          k = klist[kk];
-          ktag = tag[k];
-          ktype = map[type[k]];
-          if (softflag[jtype][ktype]) {
-            ijparam = elem2param[jtype][ktype][ktype];
-            bigr = soft[elem2soft[jtype][ktype]].bigr;
-            bigd = soft[elem2soft[jtype][ktype]].bigd;
-            delx = x[j][0] - x[k][0];
-            dely = x[j][1] - x[k][1];
-            delz = x[j][2] - x[k][2];
-            rsq = delx*delx + dely*dely + delz*delz;
-            r = sqrt(rsq) / params[ijparam].sigma;
-
-            if (r > (bigr - bigd) && r < (bigr + bigd))
-              dfcik = - 0.5/bigd + cos(PIVAL*(r-bigr+bigd)/bigd)/(2*bigd);
-            else
-              dfcik = 0;
-
-            evdwl = evdwl / gij;
-            fpair = dgij * dfcik * evdwl / rsq;
-            f[j][0] -= delx * fpair;
-            f[j][1] -= dely * fpair;
-            f[j][2] -= delz * fpair;
-            f[k][0] += delx * fpair;
-            f[k][1] += dely * fpair;
-            f[k][2] += delz * fpair;
-            if (evflag) 
-              ev_tally(j, k, nlocal, newton_pair, 0.0, 0.0, fpair, delx, dely, delz);
-          }
+
+      if (rsq < pp.cutshortsq) {
+        shortrsq[numshort] = rsq;
+        shortelem[numshort] = jtype;
+        neighshort[numshort++] = j;
+        if (numshort >= maxshort) {
+          maxshort += maxshort/2;
+          grow_short();
         }
       }
 
-    }
+      if (jj >= jhalf) continue;
+
+      if (rsq > pp.cutpairsq) continue;
+      ijparam = pp.ijparam;
+
+      // defer softened pairs, I softened by J takes precedence
+
+      if (pp.isoft >= 0) side = 0;
+      else if (pairparam[pairindex<NELEM>(jtype,itype)].isoft >= 0) side = 1;
+      else side = -1;
+
+      if (side >= 0) {
+        twobody(&params[ijparam], rsq, fpair, 1, evdwl);
+        nsoftpair++;
+        DeferPair &dp = defer[ndefer++];
+        dp.i = i;
+        dp.j = j;
+        dp.soft = side ? j : i;
+        dp.col = side ? 2*itype : 2*jtype;
+        dp.delx = delx;
+        dp.dely = dely;
+        dp.delz = delz;
+        dp.fpair = fpair;
+        dp.evdwl = evdwl;
+        continue;
+      }
 
-    jnumm1 = jnum - 1;
+      // unsoftened pairs are the rRESPA inner level, the outer level
+      // only tallies their energy and virial
 
-    for (jj = 0; jj < jnumm1; jj++) {
-      j = jlist[jj];
-      jtype = map[type[j]];
-      delr1[0] = x[j][0] - xtmp;
-      delr1[1] = x[j][1] - ytmp;
-      delr1[2] = x[j][2] - ztmp;
-      rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
-  
-      for (kk = jj+1; kk < jnum; kk++) {
-        k = jlist[kk];
-        ktype = map[type[k]];
-        ijkparam = elem2param[itype][jtype][ktype];
-    
-        if (rsq1 > params[ijkparam].cutijsq) continue;
-    
-        delr2[0] = x[k][0] - xtmp;
-        delr2[1] = x[k][1] - ytmp;
-        delr2[2] = x[k][2] - ztmp;
-        rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
-    
-        if (rsq2 > params[ijkparam].cutiksq) continue;
-    
-        threebody(&params[ijkparam], rsq1, rsq2, delr1, delr2, fj, fk, eflag, evdwl);
-    
-        f[i][0] -= fj[0] + fk[0];
-        f[i][1] -= fj[1] + fk[1];
-        f[i][2] -= fj[2] + fk[2];
-        f[j][0] += fj[0];
-        f[j][1] += fj[1];
-        f[j][2] += fj[2];
-        f[k][0] += fk[0];
-        f[k][1] += fk[1];
-        f[k][2] += fk[2];
-        
-        if (evflag) 
-          ev_tally3(i, j, k, evdwl, 0.0, fj, fk, delr1, delr2);
+      if (outer && !evflag) continue;
+      twobody(&params[ijparam], rsq, fpair, eflag, evdwl);
+      if (outer) {
+        ev_tally(i, j, nlocal, newton_pair, evdwl, 0.0, fpair,
+                 delx, dely, delz);
+        continue;
       }
+
+      f[i][0] += delx * fpair;
+      f[i][1] += dely * fpair;
+      f[i][2] += delz * fpair;
+      f[j][0] -= delx * fpair;
+      f[j][1] -= dely * fpair;
+      f[j][2] -= delz * fpair;
+
+      if (evflag)
+        ev_tally(i, j, nlocal, newton_pair, evdwl, 0.0, fpair, delx, dely, delz);
     }
+
+    coord[i] = ctmp;
+    softnum[i] = nsoft - softfirst[i];
+    soften(i, itype);
+
+    atomwork[i][WNEIGH] = jnum + 0.5*numshort*(numshort-1);
+    atomwork[i][WSOFT] = nsoftpair;
+
+    if (tripflag) continue;
+    if (precision == PREC_DOUBLE)
+      eval_threebody<NELEM,double,double>(i, itype, numshort, eflag);
+    else if (precision == PREC_MIXED)
+      eval_threebody<NELEM,float,double>(i, itype, numshort, eflag);
+    else
+      eval_threebody<NELEM,float,float>(i, itype, numshort, eflag);
   }
-  if (vflag_fdotr) virial_fdotr_compute();
+
+  // communicate coordination numbers and softening of ghost atoms
+
+  comm->forward_comm_pair(this);
+
+  nall = nlocal + atom->nghost;
+  for (i = 0; i < nall; i++) dedz[i] = 0.0;
+
+  // scale the deferred pairs by g(Z) of their softened atom
+
+  for (ii = 0; ii < ndefer; ii++) {
+    const DeferPair &dp = defer[ii];
+    const double * const gs = gcn[dp.soft];
+    i = dp.i;
+    j = dp.j;
+    gij = gs[dp.col];
+    dedz[dp.soft] += gs[dp.col+1] * dp.evdwl;
+    fpair = gij * dp.fpair;
+
+    f[i][0] += dp.delx * fpair;
+    f[i][1] += dp.dely * fpair;
+    f[i][2] += dp.delz * fpair;
+    f[j][0] -= dp.delx * fpair;
+    f[j][1] -= dp.dely * fpair;
+    f[j][2] -= dp.delz * fpair;
+
+    if (evflag)
+      ev_tally(i, j, nlocal, newton_pair, gij * dp.evdwl, 0.0, fpair,
+               dp.delx, dp.dely, dp.delz);
+  }
+
+  dsoft();
 }
 
-/* ---------------------------------------------------------------------- */
+/* ----------------------------------------------------------------------
+   sum dE/dZ contributions of ghost atoms back to their owners and
+   add the force from the coordination dependence of the softening.
+   dZ_i/dr_ij is nonzero only for the transition-zone neighbors
+   cached in the coordination pass
+------------------------------------------------------------------------- */
 
-double PairSWWOO::gsoft(double cn, int i, int j)
+void PairSWWOO::dsoft()
 {
-  double ma, mb, mc, md, me, first, second;
-  int ij = elem2soft[i][j];
-   
-  ma = soft[ij].ma;
-  mb = soft[ij].mb;
-  mc = soft[ij].mc;
-  md = soft[ij].md;
-  me = soft[ij].me;
-  first = ma / ( exp((mb - cn) / mc) + 1 );
-  second = exp(md * (cn - me) * (cn - me));
-  return first * second;
+  int i, j, ii, jj, jnum;
+  double xtmp, ytmp, ztmp, delx, dely, delz, fpair;
+
+  double **x = atom->x;
+  double **f = atom->f;
+  int nlocal = atom->nlocal;
+  int newton_pair = force->newton_pair;
+  int inum = list->inum;
+  int *ilist = list->ilist;
+
+  comm->reverse_comm_pair(this);
+
+  for (ii = 0; ii < inum; ii++) {
+    i = ilist[ii];
+    if (dedz[i] == 0.0) continue;
+    xtmp = x[i][0];
+    ytmp = x[i][1];
+    ztmp = x[i][2];
+
+    jnum = softfirst[i] + softnum[i];
+    for (jj = softfirst[i]; jj < jnum; jj++) {
+      j = softneigh[jj];
+      delx = xtmp - x[j][0];
+      dely = ytmp - x[j][1];
+      delz = ztmp - x[j][2];
+      fpair = - dedz[i] * softdfc[jj];
+
+      f[i][0] += delx * fpair;
+      f[i][1] += dely * fpair;
+      f[i][2] += delz * fpair;
+      f[j][0] -= delx * fpair;
+      f[j][1] -= dely * fpair;
+      f[j][2] -= delz * fpair;
+
+      if (evflag)
+        ev_tally(i, j, nlocal, newton_pair, 0.0, 0.0, fpair, delx, dely, delz);
+    }
+  }
 }
 
-double PairSWWOO::dgsoft(double cn, int i, int j)
+/* ----------------------------------------------------------------------
+   softening function g(Z) and dg/dZ of atom I with element ielem
+   for every partner element, from its coordination number.
+   the pair loop reads them for all bonds of I, so each exp is
+   evaluated once per atom and element pair instead of once per bond
+------------------------------------------------------------------------- */
+
+void PairSWWOO::soften(int i, int ielem)
 {
-  double ma, mb, mc, md, me, first, second, third;
-  int ij = elem2soft[i][j];
-   
-  ma = soft[ij].ma;
-  mb = soft[ij].mb;
-  mc = soft[ij].mc;
-  md = soft[ij].md;
-  me = soft[ij].me;
-  first = ma / ( exp((mb - cn) / mc) + 1 );
-  second = exp(md * (cn - me) * (cn - me));
-  third = 2.0 * md * (cn - me) + 1.0 / mc / (1.0 + exp((cn - mb) / mc));
-  return first * second * third;
+  double cn;
+  double *gi = gcn[i];
+  const PairParam *pp = &pairparam[ielem*nelements];
+
+  cn = coord[i];
+  for (int jelem = 0; jelem < nelements; jelem++) {
+    if (pp[jelem].isoft < 0) {
+      gi[2*jelem] = 1.0;
+      gi[2*jelem+1] = 0.0;
+      continue;
+    }
+    if (fastflag && cn < fastzmax) {
+      gi[2*jelem] = hermite_lookup(fastg[pp[jelem].isoft], cn * fastzscale,
+                                   gi[2*jelem+1]);
+      gi[2*jelem+1] *= fastzscale;
+    } else
+      gi[2*jelem] = gsoft<1>(cn, pp[jelem].ma, pp[jelem].mb, pp[jelem].mcinv,
+                             pp[jelem].md, pp[jelem].me, gi[2*jelem+1]);
+  }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -364,13 +830,12 @@ void PairSWWOO::allocate()
 {
   allocated = 1;
   int n = atom->ntypes;
-  int num = ceil(atom->natoms);
 
-  coord = new double[num+1];
-  
   memory->create(setflag, n+1, n+1, "pair:setflag");
   memory->create(cutsq, n+1, n+1, "pair:cutsq");
   memory->create(softflag, n+1, n+1, "pair:softflag");
+  memory->create(neighshort, maxshort, "pair:neighshort");
+  grow_kbuf();
   
   map = new int[n+1];
 }
@@ -381,7 +846,91 @@ void PairSWWOO::allocate()
 
 void PairSWWOO::settings(int narg, char **arg)
 {
-  if (narg != 0) error->all(FLERR,"Illegal pair_style command");
+  // optional keywords:
+  // table N = tabulate the radial functions with N intervals in r^2
+  //   instead of evaluating pow/exp for every pair and triplet
+  // precision single/mixed/double = type of the three-body kernel math,
+  //   mixed sums forces in double, single sums them in float
+  // fused yes/no = compute coordination, pair and three-body terms in
+  //   one sweep over the neighbor list, or in separate passes. the
+  //   default is no, the multi-pass path is the reference the fused
+  //   sweep is checked against
+  // sort none/element/distance = order of the short neighbor list
+  //   used by the three-body kernel, see pair_sw_sort.h
+  // triplets yes/no = cache the candidate triplets at reneighboring
+  //   and evaluate the three-body terms in flat loops over them
+  // schedule even/cost = division of the atoms among threads in the
+  //   /omp variant, equal counts or equal estimated cost
+  // fastmath yes/no = interpolate the cutoff function of the coordination
+  //   number and the softening g(Z) in tables instead of sin/cos/exp
+
+  tabflag = ntable = 0;
+  fastflag = 0;
+  precision = PREC_DOUBLE;
+  fused = 0;
+  sortflag = NONE;
+  tripflag = 0;
+  tripbuild = -1;
+  schedflag = SCHED_COST;
+
+  int iarg = 0;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg],"table") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      ntable = force->inumeric(FLERR,arg[iarg+1]);
+      if (ntable < 2) error->all(FLERR,"Illegal pair_style command");
+      tabflag = 1;
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"precision") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"single") == 0) precision = PREC_SINGLE;
+      else if (strcmp(arg[iarg+1],"mixed") == 0) precision = PREC_MIXED;
+      else if (strcmp(arg[iarg+1],"double") == 0) precision = PREC_DOUBLE;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"fused") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"yes") == 0) fused = 1;
+      else if (strcmp(arg[iarg+1],"no") == 0) fused = 0;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"sort") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"none") == 0) sortflag = NONE;
+      else if (strcmp(arg[iarg+1],"element") == 0) sortflag = ELEMENT;
+      else if (strcmp(arg[iarg+1],"distance") == 0) sortflag = DISTANCE;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"triplets") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"yes") == 0) tripflag = 1;
+      else if (strcmp(arg[iarg+1],"no") == 0) tripflag = 0;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"schedule") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (!(suffix_flag & Suffix::OMP))
+        error->all(FLERR,"Pair style sw/woo keyword schedule requires "
+                   "pair style sw/woo/omp");
+      if (strcmp(arg[iarg+1],"even") == 0) schedflag = SCHED_EVEN;
+      else if (strcmp(arg[iarg+1],"cost") == 0) schedflag = SCHED_COST;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"fastmath") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal pair_style command");
+      if (strcmp(arg[iarg+1],"yes") == 0) fastflag = 1;
+      else if (strcmp(arg[iarg+1],"no") == 0) fastflag = 0;
+      else error->all(FLERR,"Illegal pair_style command");
+      iarg += 2;
+    } else error->all(FLERR,"Illegal pair_style command");
+  }
+
+  // re-tabulate if the potential was already read in
+
+  if (nparams) {
+    tabulate();
+    tabulate_fast();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -472,6 +1021,34 @@ void PairSWWOO::init_style()
   int irequest = neighbor->request(this, instance_me);
   neighbor->requests[irequest]->half = 0;
   neighbor->requests[irequest]->full = 1;
+
+  // rRESPA splits the potential by terms, not by distance,
+  // into the inner and outer levels only, so the inner cutoffs are unused
+
+  if (update->whichflag == 1 && strstr(update->integrate_style,"respa")) {
+    Respa *respa = (Respa *) update->integrate;
+    if (respa->level_middle >= 0)
+      error->all(FLERR,"Pair style sw/woo does not support rRESPA middle level");
+    if (respa->level_inner >= 0 &&
+        (respa->cutoff[0] != 0.0 || respa->cutoff[1] != 0.0))
+      error->all(FLERR,"Pair style sw/woo requires rRESPA inner cutoffs of 0.0");
+  }
+
+  if (tripflag && precision != PREC_DOUBLE)
+    error->all(FLERR,"Pair style sw/woo triplets keyword requires "
+               "precision double");
+
+  // select the kernel specialization
+
+  nelemspec = (nelements <= 2) ? nelements : 0;
+  softspec = 0;
+  for (int i = 0; i < nelements*nelements; i++)
+    if (pairparam[i].isoft >= 0) softspec = 1;
+
+  // ghost atoms get their coordination number and the softening
+  // function with its derivative for every partner element
+
+  comm_forward = 1 + 2*nelements;
 }
 
 /* ----------------------------------------------------------------------
@@ -480,9 +1057,33 @@ void PairSWWOO::init_style()
 
 double PairSWWOO::init_one(int i, int j)
 {
+  int n, m, ielement, jelement, isoft;
+  double rtmp, cutone;
+
   if (setflag[i][j] == 0) error->all(FLERR,"All pair coeffs are not set");
 
-  return cutmax;
+  // cutoff for this type pair only, with the elements in either order:
+  // two-body cutoff, largest three-body leg that can connect them,
+  // and the range of the cutoff function in the coordination number
+
+  cutone = 0.0;
+  for (n = 0; n < 2; n++) {
+    ielement = (n == 0) ? map[i] : map[j];
+    jelement = (n == 0) ? map[j] : map[i];
+    m = elem2param[ielement][jelement][jelement];
+
+    if (params[m].cutpair > cutone) cutone = params[m].cutpair;
+    rtmp = sqrt(cutshortsq[ielement][jelement]);
+    if (rtmp > cutone) cutone = rtmp;
+
+    if (softflag[ielement][jelement]) {
+      isoft = elem2soft[ielement][jelement];
+      rtmp = (soft[isoft].bigr + soft[isoft].bigd) * params[m].sigma;
+      if (rtmp > cutone) cutone = rtmp;
+    }
+  }
+
+  return cutone;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -731,6 +1332,15 @@ void PairSWWOO::setup()
     }
   }
 
+  // flat copy of elem2param for the specialized kernels
+
+  memory->destroy(e2p);
+  memory->create(e2p, nelements*nelements*nelements, "pair:e2p");
+  for (i = 0; i < nelements; i++)
+    for (j = 0; j < nelements; j++)
+      for (k = 0; k < nelements; k++)
+        e2p[(i*nelements+j)*nelements+k] = elem2param[i][j][k];
+
   // compute parameter values derived from inputs
 
   // set cutsq using shortcut to reduce neighbor list for accelerated
@@ -775,6 +1385,26 @@ void PairSWWOO::setup()
                    pow(params[m].sigma, params[m].powerq);
   }
 
+  // set cutshortsq for each element pair I,J to the largest three-body
+  // cutoff in which J can appear, as the IJ leg or as the IK leg
+
+  if (cutshortsq) memory->destroy(cutshortsq);
+  memory->create(cutshortsq, nelements, nelements, "pair:cutshortsq");
+
+  for (i = 0; i < nelements; i++) {
+    for (j = 0; j < nelements; j++) {
+      cutshortsq[i][j] = 0.0;
+      for (k = 0; k < nelements; k++) {
+        n = elem2param[i][j][k];
+        if (params[n].cutijsq > cutshortsq[i][j]) 
+          cutshortsq[i][j] = params[n].cutijsq;
+        n = elem2param[i][k][j];
+        if (params[n].cutiksq > cutshortsq[i][j]) 
+          cutshortsq[i][j] = params[n].cutiksq;
+      }
+    }
+  }
+
   // set cutmax to max of all params
 
   cutmax = 0.0;
@@ -786,24 +1416,279 @@ void PairSWWOO::setup()
     rtmp3 = sqrt(params[m].cutiksq);
     if (rtmp3 > cutmax) cutmax = rtmp3;
   }
+
+  // packed block of everything the neighbor loops read for pair I,J
+  // softening bounds are squared distances, so the coordination pass
+  // takes a square root only in the transition zone
+
+  memory->sfree(pairparam);
+  pairparam = (PairParam *)
+    memory->smalloc(nelements*nelements*sizeof(PairParam), "pair:pairparam");
+  memset(pairparam, 0, nelements*nelements*sizeof(PairParam));
+
+  for (i = 0; i < nelements; i++) {
+    for (j = 0; j < nelements; j++) {
+      PairParam &pp = pairparam[i*nelements+j];
+      m = elem2param[i][j][j];
+      pp.cutshortsq = cutshortsq[i][j];
+      pp.cutpairsq = params[m].cutpairsq;
+      pp.sigmainv = 1.0 / params[m].sigma;
+      pp.ijparam = m;
+      pp.isoft = o = elem2soft[i][j];
+      if (o < 0) continue;
+
+      rtmp1 = (soft[o].bigr - soft[o].bigd) * params[m].sigma;
+      rtmp2 = (soft[o].bigr + soft[o].bigd) * params[m].sigma;
+      pp.softlosq = rtmp1 * rtmp1;
+      pp.softhisq = rtmp2 * rtmp2;
+      pp.softlo = soft[o].bigr - soft[o].bigd;
+      pp.pibigd = PIVAL / soft[o].bigd;
+      pp.inv2bigd = 0.5 / soft[o].bigd;
+      pp.fcscale = NFASTFC * pp.inv2bigd;
+      pp.ma = soft[o].ma;
+      pp.mb = soft[o].mb;
+      pp.mcinv = 1.0 / soft[o].mc;
+      pp.md = soft[o].md;
+      pp.me = soft[o].me;
+    }
+  }
+
+  tabulate();
+  tabulate_fast();
+
+  // the short neighbor cache has rows for every element
+
+  grow_kbuf();
+  memory->destroy(shortfirst);
+  memory->create(shortfirst, nelements+1, "pair:shortfirst");
+}
+
+/* ----------------------------------------------------------------------
+   tabulate the two-body energy and force and the two three-body radial
+   factors of every parameter set as functions of r^2
+
+   each table has ntable intervals between (TABINNER*sigma)^2 and the
+   cutoff squared, plus two zero entries at the cutoff. all functions
+   vanish smoothly there. pairs and triplet legs closer than the
+   inner end fall back to analytic evaluation.
+
+   linear interpolation in u = r^2 with spacing h has an error of at
+   most h^2/8 * max|d^2f/du^2| per interval. the actual error is
+   measured at the interval midpoints beyond r = sigma, i.e. over the
+   distances atoms normally have, and printed. a warning is issued above
+   TABTOL. errors of e and r^2*f are relative to the local scale
+   |e| + r^2*|f|, which does not vanish where e or f change sign.
+   a floor of TABFLOOR times its largest value beyond sigma keeps the
+   tails that vanish at the cutoff from dominating
+------------------------------------------------------------------------- */
+
+void PairSWWOO::tabulate()
+{
+  int m, n, tabsave;
+  double lo, hi, delta, rsq, rsqmin, e, f, et, ft, scale, smax, err, errmax;
+
+  memory->destroy(tabpair_e);
+  memory->destroy(tabpair_f);
+  memory->destroy(tabij_e);
+  memory->destroy(tabij_f);
+  memory->destroy(tabik_e);
+  memory->destroy(tabik_f);
+  tabpair_e = tabpair_f = NULL;
+  tabij_e = tabij_f = tabik_e = tabik_f = NULL;
+
+  if (!tabflag || nparams == 0) return;
+
+  memory->create(tabpair_e, nparams, ntable+2, "pair:tabpair_e");
+  memory->create(tabpair_f, nparams, ntable+2, "pair:tabpair_f");
+  memory->create(tabij_e, nparams, ntable+2, "pair:tabij_e");
+  memory->create(tabij_f, nparams, ntable+2, "pair:tabij_f");
+  memory->create(tabik_e, nparams, ntable+2, "pair:tabik_e");
+  memory->create(tabik_f, nparams, ntable+2, "pair:tabik_f");
+
+  // twobody() must not use the tables while they are filled
+
+  tabsave = tabflag;
+  tabflag = 0;
+  errmax = 0.0;
+
+  for (m = 0; m < nparams; m++) {
+    lo = TABINNER * params[m].sigma;
+    lo = lo * lo;
+
+    // two-body energy and force
+
+    hi = params[m].cutpairsq;
+    if (lo > 0.25 * hi) lo = 0.25 * hi;
+    delta = (hi - lo) / ntable;
+    params[m].tabpairlo = lo;
+    params[m].tabpairinv = 1.0 / delta;
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + n * delta;
+      twobody(&params[m], rsq, tabpair_f[m][n], 1, tabpair_e[m][n]);
+    }
+    tabpair_e[m][ntable] = tabpair_e[m][ntable+1] = 0.0;
+    tabpair_f[m][ntable] = tabpair_f[m][ntable+1] = 0.0;
+
+    rsqmin = params[m].sigma * params[m].sigma;
+    smax = 0.0;
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + n * delta;
+      if (rsq < rsqmin) continue;
+      scale = fabs(tabpair_e[m][n]) + rsq * fabs(tabpair_f[m][n]);
+      if (scale > smax) smax = scale;
+    }
+    for (n = 0; n < ntable; n++) {
+      rsq = lo + (n + 0.5) * delta;
+      if (rsq < rsqmin) continue;
+      twobody(&params[m], rsq, f, 1, e);
+      tab_lookup(tabpair_e[m], tabpair_f[m], lo, params[m].tabpairinv, rsq, et, ft);
+      scale = fabs(e) + rsq * fabs(f) + TABFLOOR * smax;
+      if ((err = fabs(et - e) / scale) > errmax) errmax = err;
+      if ((err = rsq * fabs(ft - f) / scale) > errmax) errmax = err;
+    }
+
+    // three-body radial factors of the ij and the ik leg
+
+    lo = TABINNER * params[m].sigma;
+    lo = lo * lo;
+    hi = params[m].cutijsq;
+    if (lo > 0.25 * hi) lo = 0.25 * hi;
+    delta = (hi - lo) / ntable;
+    params[m].tabijlo = lo;
+    params[m].tabijinv = 1.0 / delta;
+    tabulate_radial(ntable, TABFLOOR, tabij_e[m], tabij_f[m], lo, delta,
+                    rsqmin, params[m].cutij, params[m].sigma_gammaij, errmax);
+
+    lo = TABINNER * params[m].sigma;
+    lo = lo * lo;
+    hi = params[m].cutiksq;
+    if (lo > 0.25 * hi) lo = 0.25 * hi;
+    delta = (hi - lo) / ntable;
+    params[m].tabiklo = lo;
+    params[m].tabikinv = 1.0 / delta;
+    tabulate_radial(ntable, TABFLOOR, tabik_e[m], tabik_f[m], lo, delta,
+                    rsqmin, params[m].cutik, params[m].sigma_gammaik, errmax);
+  }
+
+  tabflag = tabsave;
+
+  if (comm->me == 0) {
+    if (screen)
+      fprintf(screen,"  sw/woo tables: %d intervals, max relative error %g "
+              "beyond sigma\n",
+              ntable, errmax);
+    if (logfile)
+      fprintf(logfile,"  sw/woo tables: %d intervals, max relative error %g "
+              "beyond sigma\n",
+              ntable, errmax);
+  }
+  if (errmax > TABTOL && comm->me == 0)
+    error->warning(FLERR,"Pair sw/woo table error is large, increase table size");
+}
+
+/* ----------------------------------------------------------------------
+   tabulate for fastmath the cutoff function of the coordination number
+   on the normalized transition zone t = r/(2D) in [0,1], which is the
+   same for all softening sets, and g(Z) of every softening set for
+   Z < FASTZMAX. larger Z fall back to analytic evaluation.
+
+   values and derivatives are stored at the nodes and interpolated by
+   cubic Hermite polynomials, so forces are the exact derivatives of the
+   interpolated energy. the value error is at most h^4/384 times the max
+   of the 4th derivative, the derivative error is O(h^3) and vanishes at
+   midpoints. the actual error of both is measured at four points per
+   interval and printed, for fc relative to the largest value of each
+   function, for g(Z) relative to |g| + |dg/dZ| at that point.
+   a warning is issued above TABTOL
+------------------------------------------------------------------------- */
+
+void PairSWWOO::tabulate_fast()
+{
+  int n, o, nz;
+  double t, z, f, df, ft, dft, mcinv, err, errfc, errg;
+
+  memory->destroy(fastfc);
+  memory->destroy(fastg);
+  fastfc = NULL;
+  fastg = NULL;
+
+  if (!fastflag || nparams == 0) return;
+
+  // fc(t) = soft_fc() with D = 1/2, one extra node in case t rounds to 1
+
+  memory->create(fastfc, 2*(NFASTFC+2), "pair:fastfc");
+  for (n = 0; n <= NFASTFC; n++) {
+    t = (double) n / NFASTFC;
+    fastfc[2*n] = soft_fc<1>(t, 2.0*PIVAL, 1.0, df);
+    fastfc[2*n+1] = df / NFASTFC;
+  }
+  fastfc[2*NFASTFC+2] = fastfc[2*NFASTFC];
+  fastfc[2*NFASTFC+3] = fastfc[2*NFASTFC+1];
+
+  errfc = 0.0;
+  for (n = 0; n < 4*NFASTFC; n++) {
+    t = (0.25*n + 0.125) / NFASTFC;
+    f = soft_fc<1>(t, 2.0*PIVAL, 1.0, df);
+    ft = hermite_lookup(fastfc, t * NFASTFC, dft);
+    dft *= NFASTFC;
+    if ((err = fabs(ft - f)) > errfc) errfc = err;
+    if ((err = 0.5 * fabs(dft - df)) > errfc) errfc = err;
+  }
+
+  // g(Z) and dg/dZ of every softening set
+
+  fastzmax = FASTZMAX;
+  fastzscale = FASTZSTEP;
+  nz = static_cast<int> (FASTZMAX * FASTZSTEP);
+  memory->create(fastg, nsofts, 2*(nz+1), "pair:fastg");
+
+  errg = 0.0;
+  for (o = 0; o < nsofts; o++) {
+    mcinv = 1.0 / soft[o].mc;
+    for (n = 0; n <= nz; n++) {
+      z = (double) n / FASTZSTEP;
+      fastg[o][2*n] = gsoft<1>(z, soft[o].ma, soft[o].mb, mcinv,
+                               soft[o].md, soft[o].me, df);
+      fastg[o][2*n+1] = df / FASTZSTEP;
+    }
+    for (n = 0; n < 4*nz; n++) {
+      z = (0.25*n + 0.125) / FASTZSTEP;
+      f = gsoft<1>(z, soft[o].ma, soft[o].mb, mcinv,
+                   soft[o].md, soft[o].me, df);
+      ft = hermite_lookup(fastg[o], z * FASTZSTEP, dft);
+      dft *= FASTZSTEP;
+      if (fabs(f) + fabs(df) == 0.0) continue;
+      err = fabs(ft - f);
+      if (fabs(dft - df) > err) err = fabs(dft - df);
+      err /= fabs(f) + fabs(df);
+      if (err > errg) errg = err;
+    }
+  }
+
+  if (comm->me == 0) {
+    if (screen)
+      fprintf(screen,"  sw/woo fastmath: max relative error %g of fc, "
+              "%g of g(Z)\n", errfc, errg);
+    if (logfile)
+      fprintf(logfile,"  sw/woo fastmath: max relative error %g of fc, "
+              "%g of g(Z)\n", errfc, errg);
+  }
+  if ((errfc > TABTOL || errg > TABTOL) && comm->me == 0)
+    error->warning(FLERR,"Pair sw/woo fastmath error is large");
 }
 
 /* ---------------------------------------------------------------------- */
 void PairSWWOO::twobody(Param *param, double rsq, double &fforce,
                           int eflag, double &eng)
 {
-  double r, rinvsq, rp, rq, rainv, rainvsq, expsrainv;
-  
-  r = sqrt(rsq);
-  rinvsq = 1.0 / rsq;
-  rp = pow(r, -param->powerp);
-  rq = pow(r, -param->powerq);
-  rainv = 1.0 / (r - param->cutpair);
-  rainvsq = rainv * rainv * r;
-  expsrainv = exp(param->sigma * rainv);
-  fforce = (param->c1 * rp - param->c2 * rq +
-            (param->c3 * rp - param->c4 * rq) * rainvsq) * expsrainv * rinvsq;
-  if (eflag) eng = (param->c5 * rp - param->c6 * rq) * expsrainv;
+  if (tabflag && rsq > param->tabpairlo) {
+    int m = param - params;
+    tab_lookup(tabpair_e[m], tabpair_f[m], param->tabpairlo, param->tabpairinv,
+               rsq, eng, fforce);
+    return;
+  }
+
+  PairSWKernel::twobody(param, param->cutpair, rsq, fforce, eflag, eng);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -813,54 +1698,440 @@ void PairSWWOO::threebody(Param *paramijk,
                            double *delr1, double *delr2,
                            double *fj, double *fk, int eflag, double &eng)
 {
-  double r1, rinvsq1, rainv1, gsrainv1, gsrainvsq1, expgsrainv1;
-  double r2, rinvsq2, rainv2, gsrainv2, gsrainvsq2, expgsrainv2;
-  double rinv12, cs, delcs, delcssq, facexp, facrad, frad1, frad2;
-  double facang, facang12, csfacang, csfac1, csfac2;
-  
-  r1 = sqrt(rsq1);
-  rinvsq1 = 1.0 / rsq1;
-  rainv1 = 1.0 / (r1 - paramijk->cutij);
-  gsrainv1 = paramijk->sigma_gammaij * rainv1;
-  gsrainvsq1 = gsrainv1 * rainv1 / r1;
-  expgsrainv1 = exp(gsrainv1);
-  
-  r2 = sqrt(rsq2);
-  rinvsq2 = 1.0 / rsq2;
-  rainv2 = 1.0 / (r2 - paramijk->cutik);
-  gsrainv2 = paramijk->sigma_gammaik * rainv2;
-  gsrainvsq2 = gsrainv2 * rainv2 / r2;
-  expgsrainv2 = exp(gsrainv2);
-  
-  rinv12 = 1.0 / (r1 * r2);
-  cs = (delr1[0]*delr2[0] + delr1[1]*delr2[1] + delr1[2]*delr2[2]) * rinv12;
-  delcs = cs - paramijk->costheta;
-  //delcssq = delcs * delcs + paramijk->alpha * delcs * delcs * delcs;
-  delcssq = delcs * delcs * (1.0 + paramijk->alpha * delcs);
-  
-  facexp = expgsrainv1 * expgsrainv2;
-  
-  // facrad = sqrt(paramijk->lambda_epsilon*paramijk->lambda_epsilon) *
-  //       facexp*delcssq;
-  
-  facrad = paramijk->lambda_epsilon * facexp * delcssq;
-  frad1 = facrad * gsrainvsq1;
-  frad2 = facrad * gsrainvsq2;
-  //facang = paramijk->lambda_epsilon2 * facexp*delcs + paramijk->alpha * paramijk->lambda_epsilon * 3.0 * facexp*delcs*delcs;
-  facang = paramijk->lambda_epsilon * facexp * delcs * (2.0 + 3.0 * paramijk->alpha * delcs);
-  facang12 = rinv12 * facang;
-  csfacang = cs * facang;
-  csfac1 = rinvsq1 * csfacang;
-  
-  fj[0] = delr1[0] * (frad1 + csfac1) - delr2[0] * facang12;
-  fj[1] = delr1[1] * (frad1 + csfac1) - delr2[1] * facang12;
-  fj[2] = delr1[2] * (frad1 + csfac1) - delr2[2] * facang12;
-  
-  csfac2 = rinvsq2 * csfacang;
-  
-  fk[0] = delr2[0] * (frad2 + csfac2) - delr1[0] * facang12;
-  fk[1] = delr2[1] * (frad2 + csfac2) - delr1[1] * facang12;
-  fk[2] = delr2[2] * (frad2 + csfac2) - delr1[2] * facang12;
-  
-  if (eflag) eng = facrad;
+  double expgsrainv1, dexpgsrainv1, expgsrainv2, dexpgsrainv2;
+  const int m = paramijk - params;
+
+  legradial(m, 0, rsq1, expgsrainv1, dexpgsrainv1);
+  legradial(m, 1, rsq2, expgsrainv2, dexpgsrainv2);
+
+  threebody(paramijk, rsq1, rsq2, delr1, delr2, expgsrainv1, dexpgsrainv1,
+            expgsrainv2, dexpgsrainv2, fj, fk, eflag, eng);
+}
+
+/* ----------------------------------------------------------------------
+   three-body term with the radial factors of both legs given
+------------------------------------------------------------------------- */
+
+void PairSWWOO::threebody(Param *paramijk,
+                           double rsq1, double rsq2,
+                           double *delr1, double *delr2,
+                           double expgsrainv1, double dexpgsrainv1,
+                           double expgsrainv2, double dexpgsrainv2,
+                           double *fj, double *fk, int eflag, double &eng)
+{
+  PairSWKernel::threebody<1>(paramijk->lambda_epsilon, paramijk->lambda_epsilon2,
+                             paramijk->costheta, paramijk->alpha, rsq1, rsq2,
+                             delr1, delr2, expgsrainv1, dexpgsrainv1,
+                             expgsrainv2, dexpgsrainv2, fj, fk, eflag, eng);
+}
+
+/* ----------------------------------------------------------------------
+   geometry and three-body radial factors of the numshort short
+   neighbors of atom i. a neighbor is the j leg of some triplets and
+   the k leg of others, with parameters that depend on the element of
+   the other leg, so both are stored for every element of the other leg.
+   this takes O(numshort) exponentials instead of O(numshort^2)
+------------------------------------------------------------------------- */
+
+template <int NELEM>
+void PairSWWOO::radial_short(int i, int itype, int numshort)
+{
+  int j, jj, jtype, e, m;
+  double rsq, r;
+
+  double **x = atom->x;
+  int *type = atom->type;
+  double **c = shortrad;
+  const int nel = NELEM ? NELEM : nelements;
+
+  for (jj = 0; jj < numshort; jj++) {
+    j = neighshort[jj];
+    jtype = elem<NELEM>(type[j]);
+    c[RDELX][jj] = x[j][0] - x[i][0];
+    c[RDELY][jj] = x[j][1] - x[i][1];
+    c[RDELZ][jj] = x[j][2] - x[i][2];
+    rsq = c[RDELX][jj]*c[RDELX][jj] + c[RDELY][jj]*c[RDELY][jj] +
+      c[RDELZ][jj]*c[RDELZ][jj];
+    c[RRSQ][jj] = rsq;
+    r = sqrt(rsq);
+
+    for (e = 0; e < nel; e++) {
+      double ** const ce = c + RRAD + NRAD*e;
+
+      // j leg of triplets i,j,k with k of element e
+
+      m = e2p[tripletindex<NELEM>(itype,jtype,e)];
+      if (rsq > params[m].cutijsq) ce[REXPJ][jj] = ce[RDEXPJ][jj] = 0.0;
+      else if (tabflag && rsq > params[m].tabijlo)
+        tab_lookup(tabij_e[m], tabij_f[m], params[m].tabijlo,
+                   params[m].tabijinv, rsq, ce[REXPJ][jj], ce[RDEXPJ][jj]);
+      else exp_radial(r, params[m].cutij, params[m].sigma_gammaij,
+                      ce[REXPJ][jj], ce[RDEXPJ][jj]);
+
+      // k leg of triplets i,j,k with j of element e
+
+      m = e2p[tripletindex<NELEM>(itype,e,jtype)];
+      if (rsq > params[m].cutiksq) ce[REXPK][jj] = ce[RDEXPK][jj] = 0.0;
+      else if (tabflag && rsq > params[m].tabiklo)
+        tab_lookup(tabik_e[m], tabik_f[m], params[m].tabiklo,
+                   params[m].tabikinv, rsq, ce[REXPK][jj], ce[RDEXPK][jj]);
+      else exp_radial(r, params[m].cutik, params[m].sigma_gammaik,
+                      ce[REXPK][jj], ce[RDEXPK][jj]);
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   three-body terms centered on atom i, for all pairs of its numshort
+   short neighbors. flt_t is the type of the kernel math, acc_t the type
+   the forces on i and j are summed in.
+   for each j, the k partners within both cutoffs are compacted into
+   SoA rows of kbuf together with the cached radial factors of both
+   legs, so the kernel loops carry no branches and can be vectorized.
+   forces are scattered in a scalar loop
+------------------------------------------------------------------------- */
+
+template <int NELEM, class flt_t, class acc_t>
+void PairSWWOO::eval_threebody(int i, int itype, int numshort, int eflag)
+{
+  int j, k, jj, kk, krun, kend, nk, ntrip_i, jtype, ktype, ijkparam;
+  double delr1[3], delr2[3], fj[3], fk[3], rsq1, rsq2, evdwl;
+  double cutiksq;
+  acc_t fxtmpi, fytmpi, fztmpi, fxtmpj, fytmpj, fztmpj;
+  flt_t **rows;
+
+  double **f = atom->f;
+  double **c = shortrad;
+
+  if (numshort < 2) return;
+
+  // optionally group the short neighbors by element, so the k partners
+  // come in long runs of one element with their parameters hoisted
+
+  if (sortflag != NONE)
+    sort_short(numshort, nelements, sortflag, neighshort, shortrsq, shortelem,
+               shortfirst, sortneigh, sortrsq);
+  short_runs(numshort, shortelem, shortend);
+  radial_short<NELEM>(i, itype, numshort);
+
+  kbuf_rows(rows);
+  int *_noalias const kpar = kparam;
+  flt_t *_noalias const kdelx = rows[KDELX];
+  flt_t *_noalias const kdely = rows[KDELY];
+  flt_t *_noalias const kdelz = rows[KDELZ];
+  flt_t *_noalias const krsq = rows[KRSQ];
+  flt_t *_noalias const e1 = rows[KEXP1];
+  flt_t *_noalias const d1 = rows[KDEXP1];
+  flt_t *_noalias const e2 = rows[KEXP2];
+  flt_t *_noalias const d2 = rows[KDEXP2];
+  const flt_t *_noalias const fjx = rows[KFJX];
+  const flt_t *_noalias const fjy = rows[KFJY];
+  const flt_t *_noalias const fjz = rows[KFJZ];
+  const flt_t *_noalias const fkx = rows[KFKX];
+  const flt_t *_noalias const fky = rows[KFKY];
+  const flt_t *_noalias const fkz = rows[KFKZ];
+  const flt_t *_noalias const keng = rows[KENG];
+
+  fxtmpi = fytmpi = fztmpi = 0.0;
+  ntrip_i = 0;
+
+  for (jj = 0; jj < numshort-1; jj++) {
+    j = neighshort[jj];
+    jtype = shortelem[jj];
+    delr1[0] = c[RDELX][jj];
+    delr1[1] = c[RDELY][jj];
+    delr1[2] = c[RDELZ][jj];
+    rsq1 = c[RRSQ][jj];
+
+    nk = 0;
+    for (kk = jj+1; kk < numshort; kk = kend) {
+      kend = shortend[kk];
+      ktype = shortelem[kk];
+      ijkparam = e2p[tripletindex<NELEM>(itype,jtype,ktype)];
+
+      if (rsq1 > params[ijkparam].cutijsq) continue;
+
+      cutiksq = params[ijkparam].cutiksq;
+      const flt_t ej = c[RRAD + NRAD*ktype + REXPJ][jj];
+      const flt_t dj = c[RRAD + NRAD*ktype + RDEXPJ][jj];
+      const double * const ek = c[RRAD + NRAD*jtype + REXPK];
+      const double * const dk = c[RRAD + NRAD*jtype + RDEXPK];
+
+      for (krun = kk; krun < kend; krun++) {
+        rsq2 = c[RRSQ][krun];
+
+        if (rsq2 > cutiksq) {
+          if (sortflag == DISTANCE) break;
+          continue;
+        }
+
+        kneigh[nk] = neighshort[krun];
+        kpar[nk] = ijkparam;
+        kdelx[nk] = c[RDELX][krun];
+        kdely[nk] = c[RDELY][krun];
+        kdelz[nk] = c[RDELZ][krun];
+        krsq[nk] = rsq2;
+        e1[nk] = ej;
+        d1[nk] = dj;
+        e2[nk] = ek[krun];
+        d2[nk] = dk[krun];
+        nk++;
+      }
+    }
+    if (nk == 0) continue;
+    ntrip_i += nk;
+
+    threebody_block<flt_t>(nk, rsq1, delr1);
+
+    fxtmpj = fytmpj = fztmpj = 0.0;
+    for (kk = 0; kk < nk; kk++) {
+      k = kneigh[kk];
+      fxtmpj += fjx[kk];
+      fytmpj += fjy[kk];
+      fztmpj += fjz[kk];
+      fxtmpi -= fjx[kk] + fkx[kk];
+      fytmpi -= fjy[kk] + fky[kk];
+      fztmpi -= fjz[kk] + fkz[kk];
+      f[k][0] += fkx[kk];
+      f[k][1] += fky[kk];
+      f[k][2] += fkz[kk];
+
+      if (evflag) {
+        fj[0] = fjx[kk];
+        fj[1] = fjy[kk];
+        fj[2] = fjz[kk];
+        fk[0] = fkx[kk];
+        fk[1] = fky[kk];
+        fk[2] = fkz[kk];
+        delr2[0] = kdelx[kk];
+        delr2[1] = kdely[kk];
+        delr2[2] = kdelz[kk];
+        evdwl = eflag ? keng[kk] : 0.0;
+        ev_tally3(i, j, k, evdwl, 0.0, fj, fk, delr1, delr2);
+      }
+    }
+    f[j][0] += fxtmpj;
+    f[j][1] += fytmpj;
+    f[j][2] += fztmpj;
+  }
+
+  f[i][0] += fxtmpi;
+  f[i][1] += fytmpi;
+  f[i][2] += fztmpi;
+  atomwork[i][WTRIP] = ntrip_i;
+}
+
+/* ----------------------------------------------------------------------
+   three-body terms of one i-j leg with the nk compacted k partners in
+   kbuf/kparam, same expressions as threebody() but evaluated in flt_t
+   from the radial factors gathered into kbuf.
+   fills the per-triplet forces on j and k and the energy rows of kbuf
+------------------------------------------------------------------------- */
+
+template <class flt_t>
+void PairSWWOO::threebody_block(int nk, double rsq1in, double *delr1)
+{
+  int kk;
+  flt_t **rows;
+
+  kbuf_rows(rows);
+  const Param *_noalias const p = params;
+  const int *_noalias const kpar = kparam;
+  const flt_t *_noalias const kdelx = rows[KDELX];
+  const flt_t *_noalias const kdely = rows[KDELY];
+  const flt_t *_noalias const kdelz = rows[KDELZ];
+  const flt_t *_noalias const krsq = rows[KRSQ];
+  const flt_t *_noalias const e1 = rows[KEXP1];
+  const flt_t *_noalias const d1 = rows[KDEXP1];
+  const flt_t *_noalias const e2 = rows[KEXP2];
+  const flt_t *_noalias const d2 = rows[KDEXP2];
+  flt_t *_noalias const fjx = rows[KFJX];
+  flt_t *_noalias const fjy = rows[KFJY];
+  flt_t *_noalias const fjz = rows[KFJZ];
+  flt_t *_noalias const fkx = rows[KFKX];
+  flt_t *_noalias const fky = rows[KFKY];
+  flt_t *_noalias const fkz = rows[KFKZ];
+  flt_t *_noalias const eng = rows[KENG];
+  const flt_t rsq1 = rsq1in;
+  const flt_t rinvsq1 = (flt_t) 1.0 / rsq1;
+  const flt_t dx1 = delr1[0];
+  const flt_t dy1 = delr1[1];
+  const flt_t dz1 = delr1[2];
+
+  // angular term including the cubic alpha correction
+
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+  for (kk = 0; kk < nk; kk++) {
+    const int mm = kpar[kk];
+    const flt_t lambda_epsilon = p[mm].lambda_epsilon;
+    const flt_t alpha = p[mm].alpha;
+    const flt_t rsq2 = krsq[kk];
+    const flt_t rinvsq2 = (flt_t) 1.0 / rsq2;
+    const flt_t rinv12 = (flt_t) 1.0 / sqrt(rsq1 * rsq2);
+    const flt_t cs = (dx1*kdelx[kk] + dy1*kdely[kk] + dz1*kdelz[kk]) * rinv12;
+    const flt_t delcs = cs - (flt_t) p[mm].costheta;
+    const flt_t delcssq = delcs * delcs * ((flt_t) 1.0 + alpha * delcs);
+    const flt_t facexp = e1[kk] * e2[kk];
+    const flt_t frad1 = lambda_epsilon * delcssq * d1[kk] * e2[kk];
+    const flt_t frad2 = lambda_epsilon * delcssq * e1[kk] * d2[kk];
+    const flt_t facang = lambda_epsilon * facexp * delcs *
+      ((flt_t) 2.0 + (flt_t) 3.0 * alpha * delcs);
+    const flt_t facang12 = rinv12 * facang;
+    const flt_t csfacang = cs * facang;
+    const flt_t fac1 = frad1 + rinvsq1 * csfacang;
+    const flt_t fac2 = frad2 + rinvsq2 * csfacang;
+
+    fjx[kk] = dx1 * fac1 - kdelx[kk] * facang12;
+    fjy[kk] = dy1 * fac1 - kdely[kk] * facang12;
+    fjz[kk] = dz1 * fac1 - kdelz[kk] * facang12;
+    fkx[kk] = kdelx[kk] * fac2 - dx1 * facang12;
+    fky[kk] = kdely[kk] * fac2 - dy1 * facang12;
+    fkz[kk] = kdelz[kk] * fac2 - dz1 * facang12;
+    eng[kk] = lambda_epsilon * facexp * delcssq;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   grow the short neighbor list and its per neighbor data to maxshort
+------------------------------------------------------------------------- */
+
+void PairSWWOO::grow_short()
+{
+  memory->grow(neighshort, maxshort, "pair:neighshort");
+  grow_kbuf();
+}
+
+/* ----------------------------------------------------------------------
+   (re)allocate the SoA rows of the three-body kernel for maxshort
+   partners. row length is padded to a multiple of 64 bytes, so with
+   the aligned allocation of memory->create() every row starts on a
+   cache line and vector loads need no peeling
+------------------------------------------------------------------------- */
+
+void PairSWWOO::grow_kbuf()
+{
+  const int npad = (maxshort + 15) & ~15;
+
+  memory->destroy(kbuf);
+  memory->destroy(kbuf_single);
+  memory->create(kbuf, NKBUF, npad, "pair:kbuf");
+  memory->create(kbuf_single, NKBUF, npad, "pair:kbuf_single");
+  memory->grow(kneigh, maxshort, "pair:kneigh");
+  memory->grow(kparam, maxshort, "pair:kparam");
+  memory->destroy(shortrad);
+  memory->create(shortrad, RRAD + NRAD*nelements, maxshort, "pair:shortrad");
+  memory->grow(shortrsq, maxshort, "pair:shortrsq");
+  memory->grow(shortelem, maxshort, "pair:shortelem");
+  memory->grow(shortend, maxshort, "pair:shortend");
+  memory->grow(sortneigh, maxshort, "pair:sortneigh");
+  memory->grow(sortrsq, maxshort, "pair:sortrsq");
+  memory->destroy(legmap);
+  memory->create(legmap, 2*maxshort*nelements, "pair:legmap");
+}
+
+/* ---------------------------------------------------------------------- */
+
+int PairSWWOO::pack_forward_comm(int n, int *list, double *buf,
+                                int pbc_flag, int *pbc)
+{
+  int i, j, k, m;
+
+  m = 0;
+  for (i = 0; i < n; i++) {
+    j = list[i];
+    buf[m++] = coord[j];
+  }
+
+  // the softening cache is only allocated by styles that fill it
+
+  if (gcn) {
+    const int ncache = 2*nelements;
+    for (i = 0; i < n; i++) {
+      j = list[i];
+      for (k = 0; k < ncache; k++) buf[m++] = gcn[j][k];
+    }
+  }
+  return m;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWOO::unpack_forward_comm(int n, int first, double *buf)
+{
+  int i, k, m, last;
+
+  m = 0;
+  last = first + n;
+  for (i = first; i < last; i++) coord[i] = buf[m++];
+
+  if (gcn) {
+    const int ncache = 2*nelements;
+    for (i = first; i < last; i++)
+      for (k = 0; k < ncache; k++) gcn[i][k] = buf[m++];
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+int PairSWWOO::pack_reverse_comm(int n, int first, double *buf)
+{
+  int i, m, last;
+
+  m = 0;
+  last = first + n;
+  for (i = first; i < last; i++) buf[m++] = dedz[i];
+  return m;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWOO::unpack_reverse_comm(int n, int *list, double *buf)
+{
+  int i, j, m;
+
+  m = 0;
+  for (i = 0; i < n; i++) {
+    j = list[i];
+    dedz[j] += buf[m++];
+  }
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of local atom-based arrays
+------------------------------------------------------------------------- */
+
+double PairSWWOO::memory_usage()
+{
+  double bytes = 2 * nmax * sizeof(double);
+  if (gcn) bytes += 2 * nelements * nmax * sizeof(double);
+  bytes += 3 * nmax * sizeof(int);
+  if (atomwork) bytes += NWORK * nmax * sizeof(double);
+  bytes += maxsoft * (sizeof(int) + sizeof(double));
+  bytes += maxdefer * sizeof(DeferPair);
+  bytes += maxshort * 3 * sizeof(int);
+  bytes += ((maxshort + 15) & ~15) * NKBUF * (sizeof(double) + sizeof(float));
+  bytes += maxshort * (RRAD + NRAD*nelements) * sizeof(double);
+  bytes += maxshort * 3 * (sizeof(int) + sizeof(double));
+  bytes += 2 * maxshort * nelements * sizeof(int);
+  bytes += maxtrip * sizeof(Triplet);
+  bytes += maxleg * (sizeof(Leg) + NLEGBUF*sizeof(double));
+  return bytes;
+}
+
+/* ----------------------------------------------------------------------
+   atomwork = per-atom work of the last step for load balancing,
+   nlocal x 3 and not per type like the arrays of other pair styles,
+   one row per local atom with the # of neighbor and neighbor-of-neighbor
+   visits, of evaluated triplets and of softened pairs it computed
+------------------------------------------------------------------------- */
+
+void *PairSWWOO::extract(const char *str, int &dim)
+{
+  if (strcmp(str,"atomwork") == 0) {
+    dim = 2;
+    return (void *) atomwork;
+  }
+  return NULL;
 }
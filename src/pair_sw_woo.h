@@ -30,6 +30,8 @@ PairStyle(sw/woo, PairSWWOO)
 #define LMP_PAIR_SW_WOO_H
 
 #include "pair.h"
+#include "pair_sw_kernel.h"
+#include "pair_sw_sort.h"
 #define PIVAL 3.1415926535898
 
 namespace LAMMPS_NS {
@@ -39,10 +41,29 @@ class PairSWWOO : public Pair {
   PairSWWOO(class LAMMPS *);
   virtual ~PairSWWOO();
   virtual void compute(int, int);
+
+  // rRESPA: the inner level holds only the bonds no atom softens, the
+  // softened ones stay on the outer level with everything that depends
+  // on the coordination numbers. a system where most bonds are softened,
+  // like Si-O in SiO2, gains little from rRESPA
+  virtual void compute_inner();
+  virtual void compute_outer(int, int);
   void settings(int, char **);
   virtual void coeff(int, char **);
   virtual double init_one(int, int);
   virtual void init_style();
+  virtual int pack_forward_comm(int, int *, double *, int, int *);
+  virtual void unpack_forward_comm(int, int, double *);
+  virtual int pack_reverse_comm(int, int, double *);
+  virtual void unpack_reverse_comm(int, int *, double *);
+  virtual double memory_usage();
+
+  // extract("atomwork") sets dim = 2 and returns the per-atom work
+  // counts as double[nlocal][3]: neighbor visits, triplets and softened
+  // pairs of the last step. rows follow the local atom indices, not the
+  // atom types, and the array moves when the number of atoms grows.
+  // no other name is extracted and dim is left unchanged for them
+  virtual void *extract(const char *, int &);
 
   struct Param {
     double epsilon, sigma;
@@ -54,6 +75,7 @@ class PairSWWOO : public Pair {
     double cutpair, cutij, cutik, cutpairsq, cutijsq, cutiksq;
     double sigma_gammaij, sigma_gammaik, lambda_epsilon, lambda_epsilon2;
     double c1, c2, c3, c4, c5, c6;
+    double tabpairlo, tabpairinv, tabijlo, tabijinv, tabiklo, tabikinv;
     int ielement, jelement, kelement;
   };
 
@@ -62,7 +84,43 @@ class PairSWWOO : public Pair {
     int ielement, jelement;
   };
 
+  // parameters of an element pair I,J in two 64 byte halves. the first
+  // holds what every neighbor visit reads: the short list and pair
+  // cutoffs, the softening bounds of the coordination number and the
+  // indices of the two-body and softening sets. the second is read only
+  // for neighbors in the transition zone and once per atom for g(Z).
+  // the two-body coefficients stay in Param, reached through ijparam
+  // for the pairs inside the pair cutoff. the blocks are cache line
+  // aligned only if LAMMPS is built with -DLAMMPS_MEMALIGN=64
+
+  struct PairParam {
+    double cutshortsq, cutpairsq;
+    double softlosq, softhisq;     // ((R-D)*sigma)^2, ((R+D)*sigma)^2
+    double sigmainv, softlo;       // 1/sigma, R-D
+    int ijparam;                   // two-body parameter set
+    int isoft;                     // softening set, -1 if not softened
+    double pad;
+    double pibigd, inv2bigd;       // pi/D, 1/(2*D)
+    double fcscale;                // fastfc nodes per unit r, NFASTFC/(2*D)
+    double ma, mb, mcinv, md, me;  // softening function, I softened by J
+  };
+
+  // softened pair whose bare energy and force wait for g(Z)
+
+  struct DeferPair {
+    int i, j;                      // atoms of the pair
+    int soft, col;                 // softened atom and its gcn column
+    double delx, dely, delz, fpair, evdwl;
+  };
+
+  // cached candidate triplet and the legs it combines
+
+  typedef PairSWSort::Triplet Triplet;
+  typedef PairSWSort::Leg Leg;
+
  protected:
+  enum{PREC_SINGLE,PREC_MIXED,PREC_DOUBLE};
+
 
   double cutmax;             // max cutoff for all elements
   int nelements;             // # of unique elements
@@ -77,19 +135,166 @@ class PairSWWOO : public Pair {
   int maxsofts;              // max # of softening parameter sets
   Softparam *soft;           // parameter set for the bond softening
   int **softflag;
-  double *coord;
+  int *e2p;                  // elem2param as flat array
+  PairParam *pairparam;      // packed parameters of element pairs
+  int nelemspec;             // # of elements the kernel is specialized on
+  int softspec;              // 0 if the kernel can skip softening
+  double **cutshortsq;       // short neighbor list cutoff for element pairs
+  int maxshort;              // size of short neighbor list array
+  int *neighshort;           // short neighbor list array
+  int precision;             // PREC_SINGLE, PREC_MIXED or PREC_DOUBLE
+  double **kbuf;             // SoA block of k partners for three-body kernel
+  float **kbuf_single;       // same for single and mixed precision
+  int *kneigh;               // atom index of each k partner
+  int *kparam;               // parameter set of each k partner
+  double **shortrad;         // SoA geometry and radial factors of short neighbors
+  double *shortrsq;          // r^2 of short neighbors
+  int *shortelem;            // element of short neighbors
+  int *shortend;             // end of the run of equal elements
+  int *shortfirst;           // first short neighbor of each element
+  int *sortneigh;            // scratch for sorting the short list
+  double *sortrsq;
+  int sortflag;              // ordering of the short list
+  int tripflag;              // 1 if triplets are cached between reneighborings
+  int schedflag;             // division of the atoms among threads
+  int ntrip, maxtrip;        // # of cached triplets and size of trip
+  Triplet *trip;             // cached candidate triplets
+  bigint tripbuild;          // neighbor list build trip was made for
+  int nleg, maxleg;          // # of legs and size of leg
+  Leg *leg;                  // legs of the cached triplets
+  double **legbuf;           // per step geometry and radial factors of legs
+  int *legmap;               // scratch to number the legs of one atom
+  int tabflag;               // 1 if radial functions are tabulated
+  int ntable;                // # of table intervals in r^2
+  double **tabpair_e;        // tabulated two-body energy
+  double **tabpair_f;        // tabulated two-body force / r
+  double **tabij_e, **tabik_e;  // tabulated three-body radial factors
+  double **tabij_f, **tabik_f;  // and their derivative terms
+  int fastflag;              // 1 if fc and g(Z) are tabulated
+  double *fastfc;            // fc and its derivative on the transition zone
+  double **fastg;            // g(Z) and dg/dZ of every softening set
+  double fastzmax;           // end of the g(Z) tables
+  double fastzscale;         // g(Z) table nodes per unit Z
+  int nmax;                  // allocated size of per-atom arrays
+  double *coord;             // coordination number of local and ghost atoms
+  int *numhalf;              // # of neighbors at the front of the list owned by I
+  bigint halfbuild;          // neighbor list build numhalf was made for
+  double **atomwork;         // work counts of local atoms, see extract()
+  double *dedz;              // dE/dZ of local and ghost atoms
+  double **gcn;              // g(Z) and dg/dZ of atom I for each element J
+  int *softfirst;            // first entry of atom I in softneigh/softdfc
+  int *softnum;              // # of entries of atom I in softneigh/softdfc
+  int maxsoft;               // allocated size of softneigh/softdfc
+  int *softneigh;            // neighbors in the softening transition zone
+  double *softdfc;           // dfc/(sigma*r) of those neighbors
+  int fused;                 // 1 for single sweep evaluation with softening
+  int maxdefer;              // allocated size of defer
+  DeferPair *defer;          // softened pairs of the fused sweep
   
   virtual void allocate();
+  void grow_peratom();
+  void pair_inner();
   void read_file(char *);
   virtual void setup();
+  void tabulate();
+  void tabulate_fast();
   void twobody(Param *, double, double &, int, double &);
   void threebody(Param *, double, double, double *, double *,
                     double *, double *, int, double &);
-  double gsoft(double, int, int);
-  double dgsoft(double, int, int);
+  void threebody(Param *, double, double, double *, double *,
+                 double, double, double, double,
+                 double *, double *, int, double &);
+  void eval_terms(int, int);
+  template <int NELEM, int SOFTFLAG>
+  void eval(int, int);
+  template <int NELEM>
+  void eval_fused(int, int);
+  void dsoft();
+  template <int NELEM>
+  void radial_short(int, int, int);
+  template <int NELEM, class flt_t, class acc_t>
+  void eval_threebody(int, int, int, int);
+  template <class flt_t>
+  void threebody_block(int, double, double *);
+  void grow_short();
+  void grow_kbuf();
+  void kbuf_rows(double **&rows) { rows = kbuf; }
+  void kbuf_rows(float **&rows) { rows = kbuf_single; }
+  void soften(int, int);
+
+  // contribution fc of a transition-zone neighbor to the coordination
+  // number and dfc/dr, r = distance / sigma - (R-D), see soft_fc()
+
+  double soft_cut(double r, const PairParam &pp, double &dfc) const {
+    if (fastflag) {
+      const double v = PairSWKernel::hermite_lookup(fastfc, r * pp.fcscale, dfc);
+      dfc *= pp.fcscale;
+      return v;
+    }
+    return PairSWKernel::soft_fc<1>(r, pp.pibigd, pp.inv2bigd, dfc);
+  }
+
+  // element of an atom type and flat indices of element pairs and
+  // triplets, compile-time constants or strides for NELEM = 1 or 2
+
+  template <int NELEM> int elem(int itype) const {
+    return (NELEM == 1) ? 0 : map[itype];
+  }
+  template <int NELEM> int pairindex(int i, int j) const {
+    const int n = NELEM ? NELEM : nelements;
+    return i*n + j;
+  }
+  template <int NELEM> int tripletindex(int i, int j, int k) const {
+    const int n = NELEM ? NELEM : nelements;
+    return (i*n + j)*n + k;
+  }
+
+  // cached triplets of the triplets option, built and evaluated by the
+  // templates in pair_sw_sort.h, which call the leg functions below
+
+  template <class PAIR> friend void PairSWSort::half_split(PAIR *);
+  template <class PAIR> friend void PairSWSort::build_triplets(PAIR *);
+  template <class PAIR> friend void PairSWSort::eval_triplets(PAIR *, int);
+
+  double shortcut(int itype, int jtype) const {
+    return sqrt(cutshortsq[itype][jtype]);
+  }
+  double legcut(int m, int side) const {
+    return side ? params[m].cutik : params[m].cutij;
+  }
+  double legcutsq(int m, int side) const {
+    return side ? params[m].cutiksq : params[m].cutijsq;
+  }
+  void legradial(int m, int side, double rsq, double &e, double &de) const {
+    const Param &p = params[m];
+    if (side == 0) {
+      if (tabflag && rsq > p.tabijlo)
+        PairSWKernel::tab_lookup(tabij_e[m], tabij_f[m], p.tabijlo, p.tabijinv,
+                                 rsq, e, de);
+      else PairSWKernel::exp_radial(sqrt(rsq), p.cutij, p.sigma_gammaij, e, de);
+    } else {
+      if (tabflag && rsq > p.tabiklo)
+        PairSWKernel::tab_lookup(tabik_e[m], tabik_f[m], p.tabiklo, p.tabikinv,
+                                 rsq, e, de);
+      else PairSWKernel::exp_radial(sqrt(rsq), p.cutik, p.sigma_gammaik, e, de);
+    }
+  }
 };
 
 }
 
 #endif
 #endif
+
+/* ERROR/WARNING messages:
+
+E: Pair style sw/woo does not support rRESPA middle level
+
+The potential is split into the inner and outer levels only.
+
+E: Pair style sw/woo requires rRESPA inner cutoffs of 0.0
+
+The inner level is the set of bonds that no atom softens, not a
+distance range.  Use run_style respa ... inner N 0.0 0.0.
+
+*/
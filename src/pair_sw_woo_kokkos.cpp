@@ -0,0 +1,1305 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------------
+   Kokkos version of the modified Stillinger-Weber potential (sw/woo)
+   Modified from the Kokkos Stillinger-Weber style by: Stan Moore (SNL)
+------------------------------------------------------------------------- */
+
+#include "math.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "pair_sw_woo_kokkos.h"
+#include "kokkos.h"
+#include "pair_kokkos.h"
+#include "atom_kokkos.h"
+#include "neighbor.h"
+#include "neigh_request.h"
+#include "force.h"
+#include "comm.h"
+#include "memory.h"
+#include "neigh_list_kokkos.h"
+#include "error.h"
+#include "atom_masks.h"
+#include "math_const.h"
+#include "pair_sw_sort.h"
+
+using namespace LAMMPS_NS;
+using namespace MathConst;
+using namespace PairSWSort;
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+PairSWWOOKokkos<DeviceType>::PairSWWOOKokkos(LAMMPS *lmp) : PairSWWOO(lmp)
+{
+  respa_enable = 0;
+  commflag = 0;
+
+  atomKK = (AtomKokkos *) atom;
+  execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
+  datamask_read = X_MASK | F_MASK | TAG_MASK | TYPE_MASK | ENERGY_MASK | VIRIAL_MASK;
+  datamask_modify = F_MASK | ENERGY_MASK | VIRIAL_MASK;
+}
+
+/* ----------------------------------------------------------------------
+   check if allocated, since class can be destructed when incomplete
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+PairSWWOOKokkos<DeviceType>::~PairSWWOOKokkos()
+{
+  if (!copymode) {
+    memory->destroy_kokkos(k_eatom,eatom);
+    memory->destroy_kokkos(k_vatom,vatom);
+    memory->destroy_kokkos(k_coord,coord);
+    memory->destroy_kokkos(k_dedz,dedz);
+    memory->destroy(cutghost);
+    eatom = NULL;
+    vatom = NULL;
+    coord = NULL;
+    dedz = NULL;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSWWOOKokkos<DeviceType>::compute(int eflag_in, int vflag_in)
+{
+  eflag = eflag_in;
+  vflag = vflag_in;
+
+  if (eflag || vflag) ev_setup(eflag,vflag);
+  else evflag = vflag_fdotr = 0;
+
+  // reallocate per-atom arrays if necessary
+
+  if (eflag_atom) {
+    memory->destroy_kokkos(k_eatom,eatom);
+    memory->create_kokkos(k_eatom,eatom,maxeatom,"pair:eatom");
+    d_eatom = k_eatom.d_view;
+  }
+  if (vflag_atom) {
+    memory->destroy_kokkos(k_vatom,vatom);
+    memory->create_kokkos(k_vatom,vatom,maxvatom,6,"pair:vatom");
+    d_vatom = k_vatom.d_view;
+  }
+
+  // coordination numbers and dE/dZ of local and ghost atoms
+  // the host pointers coord and dedz alias the host views, so the
+  // pack/unpack routines of the parent class do the communication
+
+  if (atom->nmax > nmax) {
+    memory->destroy_kokkos(k_coord,coord);
+    memory->destroy_kokkos(k_dedz,dedz);
+    nmax = atom->nmax;
+    memory->create_kokkos(k_coord,coord,nmax,"pair:coord");
+    memory->create_kokkos(k_dedz,dedz,nmax,"pair:dedz");
+    d_coord = k_coord.template view<DeviceType>();
+    d_dedz = k_dedz.template view<DeviceType>();
+  }
+
+  atomKK->sync(execution_space,datamask_read);
+  if (eflag || vflag) atomKK->modified(execution_space,datamask_modify);
+  else atomKK->modified(execution_space,F_MASK);
+
+  x = atomKK->k_x.view<DeviceType>();
+  f = atomKK->k_f.view<DeviceType>();
+  tag = atomKK->k_tag.view<DeviceType>();
+  type = atomKK->k_type.view<DeviceType>();
+  nlocal = atom->nlocal;
+  newton_pair = force->newton_pair;
+  nall = atom->nlocal + atom->nghost;
+
+  const int inum = list->inum;
+  const int ignum = inum + list->gnum;
+  NeighListKokkos<DeviceType>* k_list = static_cast<NeighListKokkos<DeviceType>*>(list);
+  d_numneigh = k_list->d_numneigh;
+  d_neighbors = k_list->d_neighbors;
+  d_ilist = k_list->d_ilist;
+
+  copymode = 1;
+
+  EV_FLOAT ev;
+  EV_FLOAT ev_all;
+
+  // build short neighbor lists indexed by atom,
+  // of ghost atoms too for the full neighbor option
+
+  const int max_neighs = d_neighbors.dimension_1();
+  const int nshort = (neighflag == FULL) ? ignum : inum;
+  const int nrows = (neighflag == FULL) ? nall : nlocal;
+
+  if ((d_neighbors_short.dimension_1() != max_neighs) ||
+      (d_neighbors_short.dimension_0() < nrows)) {
+    d_neighbors_short = Kokkos::View<int**,DeviceType>("SWWOO::neighbors_short",nrows,max_neighs);
+  }
+  if (d_numneigh_short.dimension_0() < nrows)
+    d_numneigh_short = Kokkos::View<int*,DeviceType>("SWWOO::numneighs_short",nrows);
+  Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType,TagPairSWWOOComputeShortNeigh>(0,nshort),*this);
+
+  // coordination numbers of local atoms, then of ghost atoms
+
+  Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType,TagPairSWWOOComputeCoord>(0,inum),*this);
+  DeviceType::fence();
+
+  k_coord.template modify<DeviceType>();
+  k_coord.template sync<LMPHostType>();
+  comm->forward_comm_pair(this);
+  k_coord.template modify<LMPHostType>();
+  k_coord.template sync<DeviceType>();
+
+  Kokkos::deep_copy(d_dedz,0.0);
+
+  // two-body and three-body terms, accumulate dE/dZ
+
+  if (neighflag == HALF) {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeHalf<HALF,1> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeHalf<HALF,0> >(0,inum),*this);
+  } else if (neighflag == HALFTHREAD) {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeHalf<HALFTHREAD,1> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeHalf<HALFTHREAD,0> >(0,inum),*this);
+  } else if (neighflag == FULL) {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeFullA<FULL,1> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeFullA<FULL,0> >(0,inum),*this);
+    DeviceType::fence();
+
+    // FullB adds forces, of the energy and virial only the per-atom terms
+
+    if (eflag_atom || vflag_atom)
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeFullB<FULL,1> >(0,inum),*this);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeFullB<FULL,0> >(0,inum),*this);
+  }
+  DeviceType::fence();
+  ev_all += ev;
+
+  // with half lists sum dE/dZ contributions of ghost atoms back to
+  // their owners, with full lists dE/dZ of owned atoms is complete
+  // and is sent to their ghost images
+
+  k_dedz.template modify<DeviceType>();
+  k_dedz.template sync<LMPHostType>();
+  if (neighflag == FULL) {
+    commflag = 1;
+    comm->forward_comm_pair(this);
+    commflag = 0;
+  } else comm->reverse_comm_pair(this);
+  k_dedz.template modify<LMPHostType>();
+  k_dedz.template sync<DeviceType>();
+
+  // force from the coordination dependence of the softening function
+
+  ev = EV_FLOAT();
+  if (neighflag == HALF) {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeSoft<HALF,1> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeSoft<HALF,0> >(0,inum),*this);
+  } else if (neighflag == HALFTHREAD) {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeSoft<HALFTHREAD,1> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeSoft<HALFTHREAD,0> >(0,inum),*this);
+  } else if (neighflag == FULL) {
+    if (evflag)
+      Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeSoft<FULL,1> >(0,inum),*this,ev);
+    else
+      Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, TagPairSWWOOComputeSoft<FULL,0> >(0,inum),*this);
+  }
+  DeviceType::fence();
+  ev_all += ev;
+
+  if (eflag_global) eng_vdwl += ev_all.evdwl;
+  if (vflag_global) {
+    virial[0] += ev_all.v[0];
+    virial[1] += ev_all.v[1];
+    virial[2] += ev_all.v[2];
+    virial[3] += ev_all.v[3];
+    virial[4] += ev_all.v[4];
+    virial[5] += ev_all.v[5];
+  }
+
+  if (eflag_atom) {
+    k_eatom.template modify<DeviceType>();
+    k_eatom.template sync<LMPHostType>();
+  }
+
+  if (vflag_atom) {
+    k_vatom.template modify<DeviceType>();
+    k_vatom.template sync<LMPHostType>();
+  }
+
+  if (vflag_fdotr) pair_virial_fdotr_compute(this);
+
+  copymode = 0;
+}
+
+/* ----------------------------------------------------------------------
+   short neighbor list of atom i, neighbors that can take part in a
+   three-body term
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeShortNeigh, const int& ii) const {
+  const int i = d_ilist[ii];
+  const int itype = d_map[type[i]];
+  const X_FLOAT xtmp = x(i,0);
+  const X_FLOAT ytmp = x(i,1);
+  const X_FLOAT ztmp = x(i,2);
+
+  const int jnum = d_numneigh[i];
+  int inside = 0;
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+    const int jtype = d_map[type[j]];
+
+    const X_FLOAT delx = xtmp - x(j,0);
+    const X_FLOAT dely = ytmp - x(j,1);
+    const X_FLOAT delz = ztmp - x(j,2);
+    const F_FLOAT rsq = delx*delx + dely*dely + delz*delz;
+
+    if (rsq < d_cutshortsq(itype,jtype)) {
+      d_neighbors_short(i,inside) = j;
+      inside++;
+    }
+  }
+  d_numneigh_short(i) = inside;
+}
+
+/* ----------------------------------------------------------------------
+   coordination number of atom ii, only atom i is written
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeCoord, const int& ii) const {
+  const int i = d_ilist[ii];
+  const int itype = d_map[type[i]];
+  const X_FLOAT xtmp = x(i,0);
+  const X_FLOAT ytmp = x(i,1);
+  const X_FLOAT ztmp = x(i,2);
+
+  F_FLOAT coordi = 0.0;
+  const int jnum = d_numneigh[i];
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+    const int jtype = d_map[type[j]];
+    if (!d_softflag(itype,jtype)) continue;
+
+    const int ijparam = d_elem2param(itype,jtype,jtype);
+    const F_FLOAT bigr = d_soft[d_elem2soft(itype,jtype)].bigr;
+    const F_FLOAT bigd = d_soft[d_elem2soft(itype,jtype)].bigd;
+    const X_FLOAT delx = xtmp - x(j,0);
+    const X_FLOAT dely = ytmp - x(j,1);
+    const X_FLOAT delz = ztmp - x(j,2);
+    const F_FLOAT rsq = delx*delx + dely*dely + delz*delz;
+    const F_FLOAT r = sqrt(rsq) / d_params[ijparam].sigma;
+
+    if (r < (bigr - bigd)) coordi += 1.0;
+    else if (r < (bigr + bigd))
+      coordi += 1.0 - (r-bigr+bigd)/(2.0*bigd) +
+        sin(MY_PI*(r-bigr+bigd)/bigd)/(2.0*MY_PI);
+  }
+  d_coord[i] = coordi;
+}
+
+/* ----------------------------------------------------------------------
+   two-body and three-body terms of atom ii
+   skips half of the two-body terms, forces and dE/dZ are scattered
+   to i, j and k, atomically for the half/thread neighbor option
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int NEIGHFLAG, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeHalf<NEIGHFLAG,EVFLAG>, const int &ii, EV_FLOAT& ev) const {
+
+  // The f and dedz arrays are atomic for Half/Thread neighbor style
+  Kokkos::View<F_FLOAT*[3], typename DAT::t_f_array::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<NEIGHFLAG>::value> > a_f = f;
+  Kokkos::View<F_FLOAT*, typename DAT::t_ffloat_1d::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<NEIGHFLAG>::value> > a_dedz = d_dedz;
+
+  F_FLOAT delr1[3],delr2[3],fj[3],fk[3];
+  F_FLOAT evdwl = 0.0;
+  F_FLOAT fpair = 0.0;
+  F_FLOAT gij;
+
+  const int i = d_ilist[ii];
+  const tagint itag = tag[i];
+  const int itype = d_map[type[i]];
+  const X_FLOAT xtmp = x(i,0);
+  const X_FLOAT ytmp = x(i,1);
+  const X_FLOAT ztmp = x(i,2);
+
+  // two-body interactions, skip half of them
+
+  const int jnum = d_numneigh[i];
+
+  F_FLOAT fxtmpi = 0.0;
+  F_FLOAT fytmpi = 0.0;
+  F_FLOAT fztmpi = 0.0;
+
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+    const tagint jtag = tag[j];
+
+    if (itag > jtag) {
+      if ((itag+jtag) % 2 == 0) continue;
+    } else if (itag < jtag) {
+      if ((itag+jtag) % 2 == 1) continue;
+    } else {
+      if (x(j,2) < ztmp) continue;
+      if (x(j,2) == ztmp && x(j,1) < ytmp) continue;
+      if (x(j,2) == ztmp && x(j,1) == ytmp && x(j,0) < xtmp) continue;
+    }
+
+    const int jtype = d_map[type[j]];
+
+    const X_FLOAT delx = xtmp - x(j,0);
+    const X_FLOAT dely = ytmp - x(j,1);
+    const X_FLOAT delz = ztmp - x(j,2);
+    const F_FLOAT rsq = delx*delx + dely*dely + delz*delz;
+
+    const int ijparam = d_elem2param(itype,jtype,jtype);
+    if (rsq > d_params[ijparam].cutpairsq) continue;
+
+    // softened pairs always need the bare pair energy,
+    // it enters dE/dZ of the atom whose coordination softens the bond
+
+    if (d_softflag(itype,jtype)) {
+      const Softparam &sp = d_soft[d_elem2soft(itype,jtype)];
+      twobody(d_params[ijparam],rsq,fpair,1,evdwl);
+      gij = gsoft(sp,d_coord[i]);
+      a_dedz[i] += dgsoft(sp,d_coord[i]) * evdwl;
+    } else if (d_softflag(jtype,itype)) {
+      const Softparam &sp = d_soft[d_elem2soft(jtype,itype)];
+      twobody(d_params[ijparam],rsq,fpair,1,evdwl);
+      gij = gsoft(sp,d_coord[j]);
+      a_dedz[j] += dgsoft(sp,d_coord[j]) * evdwl;
+    } else {
+      twobody(d_params[ijparam],rsq,fpair,eflag,evdwl);
+      gij = 1.0;
+    }
+
+    evdwl *= gij;
+    fpair *= gij;
+
+    fxtmpi += delx*fpair;
+    fytmpi += dely*fpair;
+    fztmpi += delz*fpair;
+    a_f(j,0) -= delx*fpair;
+    a_f(j,1) -= dely*fpair;
+    a_f(j,2) -= delz*fpair;
+
+    if (EVFLAG) {
+      if (eflag) ev.evdwl += evdwl;
+      if (vflag_either || eflag_atom) this->template ev_tally<NEIGHFLAG>(ev,i,j,evdwl,fpair,delx,dely,delz);
+    }
+  }
+
+  // three-body interactions of all pairs of short neighbors
+
+  const int numshort = d_numneigh_short[i];
+
+  for (int jj = 0; jj < numshort-1; jj++) {
+    const int j = d_neighbors_short(i,jj);
+    const int jtype = d_map[type[j]];
+    delr1[0] = x(j,0) - xtmp;
+    delr1[1] = x(j,1) - ytmp;
+    delr1[2] = x(j,2) - ztmp;
+    const F_FLOAT rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+
+    F_FLOAT fxtmpj = 0.0;
+    F_FLOAT fytmpj = 0.0;
+    F_FLOAT fztmpj = 0.0;
+
+    for (int kk = jj+1; kk < numshort; kk++) {
+      int k = d_neighbors_short(i,kk);
+      const int ktype = d_map[type[k]];
+      const int ijkparam = d_elem2param(itype,jtype,ktype);
+
+      if (rsq1 > d_params[ijkparam].cutijsq) continue;
+
+      delr2[0] = x(k,0) - xtmp;
+      delr2[1] = x(k,1) - ytmp;
+      delr2[2] = x(k,2) - ztmp;
+      const F_FLOAT rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
+
+      if (rsq2 > d_params[ijkparam].cutiksq) continue;
+
+      threebody(d_params[ijkparam],rsq1,rsq2,delr1,delr2,fj,fk,eflag,evdwl);
+
+      fxtmpi -= fj[0] + fk[0];
+      fytmpi -= fj[1] + fk[1];
+      fztmpi -= fj[2] + fk[2];
+
+      fxtmpj += fj[0];
+      fytmpj += fj[1];
+      fztmpj += fj[2];
+
+      a_f(k,0) += fk[0];
+      a_f(k,1) += fk[1];
+      a_f(k,2) += fk[2];
+
+      if (EVFLAG) {
+        if (eflag) ev.evdwl += evdwl;
+        if (vflag_either || eflag_atom) this->template ev_tally3<NEIGHFLAG>(ev,i,j,k,evdwl,0.0,fj,fk,delr1,delr2);
+      }
+    }
+
+    a_f(j,0) += fxtmpj;
+    a_f(j,1) += fytmpj;
+    a_f(j,2) += fztmpj;
+  }
+
+  a_f(i,0) += fxtmpi;
+  a_f(i,1) += fytmpi;
+  a_f(i,2) += fztmpi;
+}
+
+template<class DeviceType>
+template<int NEIGHFLAG, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeHalf<NEIGHFLAG,EVFLAG>, const int &ii) const {
+  EV_FLOAT ev;
+  this->template operator()<NEIGHFLAG,EVFLAG>(TagPairSWWOOComputeHalf<NEIGHFLAG,EVFLAG>(), ii, ev);
+}
+
+/* ----------------------------------------------------------------------
+   two-body and three-body terms of atom ii for the full neighbor option
+   each pair is visited from both sides and writes only to atom i, the
+   atom the half kernel would keep the pair for picks the softening atom.
+   dE/dZ of atom i is complete, its triplets are tallied in full
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int NEIGHFLAG, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeFullA<NEIGHFLAG,EVFLAG>, const int &ii, EV_FLOAT& ev) const {
+
+  F_FLOAT delr1[3],delr2[3],fj[3],fk[3];
+  F_FLOAT evdwl = 0.0;
+  F_FLOAT fpair = 0.0;
+  F_FLOAT gij;
+
+  const int i = d_ilist[ii];
+  const tagint itag = tag[i];
+  const int itype = d_map[type[i]];
+  const X_FLOAT xtmp = x(i,0);
+  const X_FLOAT ytmp = x(i,1);
+  const X_FLOAT ztmp = x(i,2);
+
+  // two-body interactions, each side tallies half
+
+  const int jnum = d_numneigh[i];
+
+  F_FLOAT fxtmpi = 0.0;
+  F_FLOAT fytmpi = 0.0;
+  F_FLOAT fztmpi = 0.0;
+  F_FLOAT dedzi = 0.0;
+
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+    const tagint jtag = tag[j];
+
+    int first = i;
+    int second = j;
+    if (itag > jtag) {
+      if ((itag+jtag) % 2 == 0) { first = j; second = i; }
+    } else if (itag < jtag) {
+      if ((itag+jtag) % 2 == 1) { first = j; second = i; }
+    } else {
+      if (x(j,2) < ztmp) { first = j; second = i; }
+      else if (x(j,2) == ztmp && x(j,1) < ytmp) { first = j; second = i; }
+      else if (x(j,2) == ztmp && x(j,1) == ytmp && x(j,0) < xtmp) { first = j; second = i; }
+    }
+
+    const int ftype = d_map[type[first]];
+    const int stype = d_map[type[second]];
+
+    const X_FLOAT delx = xtmp - x(j,0);
+    const X_FLOAT dely = ytmp - x(j,1);
+    const X_FLOAT delz = ztmp - x(j,2);
+    const F_FLOAT rsq = delx*delx + dely*dely + delz*delz;
+
+    const int ijparam = d_elem2param(ftype,stype,stype);
+    if (rsq > d_params[ijparam].cutpairsq) continue;
+
+    if (d_softflag(ftype,stype)) {
+      const Softparam &sp = d_soft[d_elem2soft(ftype,stype)];
+      twobody(d_params[ijparam],rsq,fpair,1,evdwl);
+      gij = gsoft(sp,d_coord[first]);
+      if (first == i) dedzi += dgsoft(sp,d_coord[i]) * evdwl;
+    } else if (d_softflag(stype,ftype)) {
+      const Softparam &sp = d_soft[d_elem2soft(stype,ftype)];
+      twobody(d_params[ijparam],rsq,fpair,1,evdwl);
+      gij = gsoft(sp,d_coord[second]);
+      if (second == i) dedzi += dgsoft(sp,d_coord[i]) * evdwl;
+    } else {
+      twobody(d_params[ijparam],rsq,fpair,eflag,evdwl);
+      gij = 1.0;
+    }
+
+    evdwl *= gij;
+    fpair *= gij;
+
+    fxtmpi += delx*fpair;
+    fytmpi += dely*fpair;
+    fztmpi += delz*fpair;
+
+    if (EVFLAG) {
+      if (eflag) ev.evdwl += 0.5*evdwl;
+      if (vflag_either || eflag_atom) this->template ev_tally<NEIGHFLAG>(ev,i,j,evdwl,fpair,delx,dely,delz);
+    }
+  }
+
+  d_dedz[i] = dedzi;
+
+  // three-body interactions centered on i
+
+  const int numshort = d_numneigh_short[i];
+
+  for (int jj = 0; jj < numshort-1; jj++) {
+    const int j = d_neighbors_short(i,jj);
+    const int jtype = d_map[type[j]];
+    delr1[0] = x(j,0) - xtmp;
+    delr1[1] = x(j,1) - ytmp;
+    delr1[2] = x(j,2) - ztmp;
+    const F_FLOAT rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+
+    for (int kk = jj+1; kk < numshort; kk++) {
+      int k = d_neighbors_short(i,kk);
+      const int ktype = d_map[type[k]];
+      const int ijkparam = d_elem2param(itype,jtype,ktype);
+
+      if (rsq1 > d_params[ijkparam].cutijsq) continue;
+
+      delr2[0] = x(k,0) - xtmp;
+      delr2[1] = x(k,1) - ytmp;
+      delr2[2] = x(k,2) - ztmp;
+      const F_FLOAT rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
+
+      if (rsq2 > d_params[ijkparam].cutiksq) continue;
+
+      threebody(d_params[ijkparam],rsq1,rsq2,delr1,delr2,fj,fk,eflag,evdwl);
+
+      fxtmpi -= fj[0] + fk[0];
+      fytmpi -= fj[1] + fk[1];
+      fztmpi -= fj[2] + fk[2];
+
+      if (EVFLAG) {
+        if (eflag) ev.evdwl += evdwl;
+        if (vflag_either || eflag_atom) this->template ev_tally3<NEIGHFLAG>(ev,i,j,k,evdwl,0.0,fj,fk,delr1,delr2);
+      }
+    }
+  }
+
+  f(i,0) += fxtmpi;
+  f(i,1) += fytmpi;
+  f(i,2) += fztmpi;
+}
+
+template<class DeviceType>
+template<int NEIGHFLAG, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeFullA<NEIGHFLAG,EVFLAG>, const int &ii) const {
+  EV_FLOAT ev;
+  this->template operator()<NEIGHFLAG,EVFLAG>(TagPairSWWOOComputeFullA<NEIGHFLAG,EVFLAG>(), ii, ev);
+}
+
+/* ----------------------------------------------------------------------
+   force on atom ii from the three-body terms centered on its neighbors j
+   the legs keep the order of the short list of j, so the parameter set
+   is the one the half kernel uses. energy and virial were tallied by j,
+   with EVFLAG only the per-atom third of atom i is added
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int NEIGHFLAG, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeFullB<NEIGHFLAG,EVFLAG>, const int &ii) const {
+
+  F_FLOAT delr1[3],delr2[3],fi[3],fk[3];
+  F_FLOAT evdwl = 0.0;
+
+  const int i = d_ilist[ii];
+  const int itype = d_map[type[i]];
+  const X_FLOAT xtmp = x(i,0);
+  const X_FLOAT ytmp = x(i,1);
+  const X_FLOAT ztmp = x(i,2);
+
+  F_FLOAT fxtmpi = 0.0;
+  F_FLOAT fytmpi = 0.0;
+  F_FLOAT fztmpi = 0.0;
+
+  // i is in the short list of j exactly when j would list it,
+  // the short cutoffs need not be symmetric in the elements
+
+  const int jnum = d_numneigh[i];
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+    const int jtype = d_map[type[j]];
+
+    delr1[0] = xtmp - x(j,0);
+    delr1[1] = ytmp - x(j,1);
+    delr1[2] = ztmp - x(j,2);
+    const F_FLOAT rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+    if (rsq1 >= d_cutshortsq(jtype,itype)) continue;
+
+    const int numshort = d_numneigh_short[j];
+    int iafter = 0;
+
+    for (int kk = 0; kk < numshort; kk++) {
+      const int k = d_neighbors_short(j,kk);
+      if (k == i) {
+        iafter = 1;
+        continue;
+      }
+      const int ktype = d_map[type[k]];
+
+      delr2[0] = x(k,0) - x(j,0);
+      delr2[1] = x(k,1) - x(j,1);
+      delr2[2] = x(k,2) - x(j,2);
+      const F_FLOAT rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
+
+      if (iafter) {
+        const int jikparam = d_elem2param(jtype,itype,ktype);
+        if (rsq1 > d_params[jikparam].cutijsq) continue;
+        if (rsq2 > d_params[jikparam].cutiksq) continue;
+        threebody(d_params[jikparam],rsq1,rsq2,delr1,delr2,fi,fk,eflag,evdwl);
+      } else {
+        const int jkiparam = d_elem2param(jtype,ktype,itype);
+        if (rsq2 > d_params[jkiparam].cutijsq) continue;
+        if (rsq1 > d_params[jkiparam].cutiksq) continue;
+        threebody(d_params[jkiparam],rsq2,rsq1,delr2,delr1,fk,fi,eflag,evdwl);
+      }
+
+      fxtmpi += fi[0];
+      fytmpi += fi[1];
+      fztmpi += fi[2];
+
+      if (EVFLAG) this->ev_tally3_atom(i,evdwl,0.0,fi,fk,delr1,delr2);
+    }
+  }
+
+  f(i,0) += fxtmpi;
+  f(i,1) += fytmpi;
+  f(i,2) += fztmpi;
+}
+
+/* ----------------------------------------------------------------------
+   force from the coordination dependence of the softening function
+   dZ_i/dr_ij is nonzero only for neighbors in the transition zone
+   for the full neighbor option atom i also gathers the force of the
+   coordination numbers of its neighbors and no other atom is written
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int NEIGHFLAG, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeSoft<NEIGHFLAG,EVFLAG>, const int &ii, EV_FLOAT& ev) const {
+
+  // The f array is atomic for Half/Thread neighbor style
+  Kokkos::View<F_FLOAT*[3], typename DAT::t_f_array::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<NEIGHFLAG>::value> > a_f = f;
+
+  const int i = d_ilist[ii];
+  const F_FLOAT dedzi = d_dedz[i];
+  if (NEIGHFLAG != FULL && dedzi == 0.0) return;
+
+  const int itype = d_map[type[i]];
+  const X_FLOAT xtmp = x(i,0);
+  const X_FLOAT ytmp = x(i,1);
+  const X_FLOAT ztmp = x(i,2);
+
+  F_FLOAT fxtmpi = 0.0;
+  F_FLOAT fytmpi = 0.0;
+  F_FLOAT fztmpi = 0.0;
+
+  const int jnum = d_numneigh[i];
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+    const int jtype = d_map[type[j]];
+    const X_FLOAT delx = xtmp - x(j,0);
+    const X_FLOAT dely = ytmp - x(j,1);
+    const X_FLOAT delz = ztmp - x(j,2);
+
+    if (d_softflag(itype,jtype) && dedzi != 0.0) {
+      const int ijparam = d_elem2param(itype,jtype,jtype);
+      const F_FLOAT sigma = d_params[ijparam].sigma;
+      const F_FLOAT bigr = d_soft[d_elem2soft(itype,jtype)].bigr;
+      const F_FLOAT bigd = d_soft[d_elem2soft(itype,jtype)].bigd;
+      const F_FLOAT rsq = delx*delx + dely*dely + delz*delz;
+      const F_FLOAT rs = sqrt(rsq);
+      const F_FLOAT r = rs / sigma;
+      if (r >= (bigr - bigd) && r < (bigr + bigd)) {
+        const F_FLOAT dfc = -0.5/bigd + cos(MY_PI*(r-bigr+bigd)/bigd)/(2.0*bigd);
+        const F_FLOAT fpair = - dedzi * dfc / (sigma * rs);
+
+        fxtmpi += delx*fpair;
+        fytmpi += dely*fpair;
+        fztmpi += delz*fpair;
+        if (NEIGHFLAG != FULL) {
+          a_f(j,0) -= delx*fpair;
+          a_f(j,1) -= dely*fpair;
+          a_f(j,2) -= delz*fpair;
+        }
+
+        if (EVFLAG) {
+          if (vflag_either) this->template ev_tally<NEIGHFLAG>(ev,i,j,0.0,fpair,delx,dely,delz);
+        }
+      }
+    }
+
+    // the coordination number of neighbor j depends on r_ij
+
+    if (NEIGHFLAG == FULL && d_softflag(jtype,itype) && d_dedz[j] != 0.0) {
+      const int jiparam = d_elem2param(jtype,itype,itype);
+      const F_FLOAT sigma = d_params[jiparam].sigma;
+      const F_FLOAT bigr = d_soft[d_elem2soft(jtype,itype)].bigr;
+      const F_FLOAT bigd = d_soft[d_elem2soft(jtype,itype)].bigd;
+      const F_FLOAT rsq = delx*delx + dely*dely + delz*delz;
+      const F_FLOAT rs = sqrt(rsq);
+      const F_FLOAT r = rs / sigma;
+      if (r >= (bigr - bigd) && r < (bigr + bigd)) {
+        const F_FLOAT dfc = -0.5/bigd + cos(MY_PI*(r-bigr+bigd)/bigd)/(2.0*bigd);
+        const F_FLOAT fpair = - d_dedz[j] * dfc / (sigma * rs);
+
+        fxtmpi += delx*fpair;
+        fytmpi += dely*fpair;
+        fztmpi += delz*fpair;
+
+        if (EVFLAG) {
+          if (vflag_either) this->template ev_tally<NEIGHFLAG>(ev,i,j,0.0,fpair,delx,dely,delz);
+        }
+      }
+    }
+  }
+
+  a_f(i,0) += fxtmpi;
+  a_f(i,1) += fytmpi;
+  a_f(i,2) += fztmpi;
+}
+
+template<class DeviceType>
+template<int NEIGHFLAG, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::operator()(TagPairSWWOOComputeSoft<NEIGHFLAG,EVFLAG>, const int &ii) const {
+  EV_FLOAT ev;
+  this->template operator()<NEIGHFLAG,EVFLAG>(TagPairSWWOOComputeSoft<NEIGHFLAG,EVFLAG>(), ii, ev);
+}
+
+/* ----------------------------------------------------------------------
+   set coeffs for one or more type pairs
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSWWOOKokkos<DeviceType>::coeff(int narg, char **arg)
+{
+  PairSWWOO::coeff(narg,arg);
+
+  // sync map
+
+  int n = atom->ntypes;
+
+  DAT::tdual_int_1d k_map = DAT::tdual_int_1d("pair:map",n+1);
+  HAT::t_int_1d h_map = k_map.h_view;
+
+  for (int i = 1; i <= n; i++)
+    h_map[i] = map[i];
+
+  k_map.template modify<LMPHostType>();
+  k_map.template sync<DeviceType>();
+
+  d_map = k_map.template view<DeviceType>();
+}
+
+/* ----------------------------------------------------------------------
+   init specific to this pair style
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSWWOOKokkos<DeviceType>::init_style()
+{
+  PairSWWOO::init_style();
+
+  if (tabflag)
+    error->all(FLERR,"Pair style sw/woo/kk does not support the table keyword");
+  if (precision != PREC_DOUBLE)
+    error->all(FLERR,"Pair style sw/woo/kk does not support the precision keyword");
+  if (fastflag)
+    error->all(FLERR,"Pair style sw/woo/kk does not support the fastmath keyword");
+  if (sortflag != NONE)
+    error->all(FLERR,"Pair style sw/woo/kk does not support the sort keyword");
+  if (tripflag)
+    error->all(FLERR,"Pair style sw/woo/kk does not support the triplets keyword");
+  if (fused)
+    error->all(FLERR,"Pair style sw/woo/kk does not support the fused keyword");
+
+  // irequest = neigh request made by parent class
+
+  neighflag = lmp->kokkos->neighflag;
+  int irequest = neighbor->nrequest - 1;
+
+  neighbor->requests[irequest]->
+    kokkos_host = Kokkos::Impl::is_same<DeviceType,LMPHostType>::value &&
+    !Kokkos::Impl::is_same<DeviceType,LMPDeviceType>::value;
+  neighbor->requests[irequest]->
+    kokkos_device = Kokkos::Impl::is_same<DeviceType,LMPDeviceType>::value;
+
+  // always request a full neighbor list, with the full neighbor option
+  // of ghost atoms too for the three-body terms centered on them
+
+  if (neighflag == FULL || neighflag == HALF || neighflag == HALFTHREAD) {
+    neighbor->requests[irequest]->full = 1;
+    neighbor->requests[irequest]->half = 0;
+    neighbor->requests[irequest]->full_cluster = 0;
+    neighbor->requests[irequest]->ghost = (neighflag == FULL);
+  } else {
+    error->all(FLERR,"Cannot use chosen neighbor list style with pair sw/woo/kk");
+  }
+
+  // ghost atoms get no forces with the full neighbor option,
+  // so the virial is tallied per interaction
+
+  ghostneigh = (neighflag == FULL);
+  no_virial_fdotr_compute = (neighflag == FULL);
+  if (neighflag != FULL) return;
+
+  if (comm->cutghostuser < 2.0*cutmax + neighbor->skin)
+    error->all(FLERR,"Pair style sw/woo/kk with neigh full requires a ghost "
+               "cutoff of twice the pair cutoff");
+
+  memory->destroy(cutghost);
+  memory->create(cutghost,atom->ntypes+1,atom->ntypes+1,"pair:cutghost");
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+double PairSWWOOKokkos<DeviceType>::init_one(int i, int j)
+{
+  double cut = PairSWWOO::init_one(i,j);
+  if (neighflag == FULL) cutghost[i][j] = cutghost[j][i] = cut;
+  return cut;
+}
+
+/* ----------------------------------------------------------------------
+   with commflag set, send dE/dZ of owned atoms to their ghost images
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+int PairSWWOOKokkos<DeviceType>::pack_forward_comm(int n, int *list, double *buf,
+                                                   int pbc_flag, int *pbc)
+{
+  int i,m;
+
+  if (!commflag) return PairSWWOO::pack_forward_comm(n,list,buf,pbc_flag,pbc);
+
+  m = 0;
+  for (i = 0; i < n; i++) buf[m++] = dedz[list[i]];
+  return m;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSWWOOKokkos<DeviceType>::unpack_forward_comm(int n, int first, double *buf)
+{
+  int i,m,last;
+
+  if (!commflag) {
+    PairSWWOO::unpack_forward_comm(n,first,buf);
+    return;
+  }
+
+  m = 0;
+  last = first + n;
+  for (i = first; i < last; i++) dedz[i] = buf[m++];
+}
+
+/* ----------------------------------------------------------------------
+   copy parameters and element maps to the device
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+void PairSWWOOKokkos<DeviceType>::setup()
+{
+  PairSWWOO::setup();
+
+  // sync elem2param, elem2soft, softflag, cutshortsq, params and soft
+
+  tdual_int_3d k_elem2param = tdual_int_3d("pair:elem2param",nelements,nelements,nelements);
+  t_host_int_3d h_elem2param = k_elem2param.h_view;
+
+  DAT::tdual_int_2d k_elem2soft = DAT::tdual_int_2d("pair:elem2soft",nelements,nelements);
+  HAT::t_int_2d h_elem2soft = k_elem2soft.h_view;
+
+  DAT::tdual_int_2d k_softflag = DAT::tdual_int_2d("pair:softflag",nelements,nelements);
+  HAT::t_int_2d h_softflag = k_softflag.h_view;
+
+  DAT::tdual_ffloat_2d k_cutshortsq = DAT::tdual_ffloat_2d("pair:cutshortsq",nelements,nelements);
+  HAT::t_ffloat_2d h_cutshortsq = k_cutshortsq.h_view;
+
+  tdual_param_1d k_params = tdual_param_1d("pair:params",nparams);
+  t_host_param_1d h_params = k_params.h_view;
+
+  tdual_soft_1d k_soft = tdual_soft_1d("pair:soft",nsofts);
+  t_host_soft_1d h_soft = k_soft.h_view;
+
+  for (int i = 0; i < nelements; i++)
+    for (int j = 0; j < nelements; j++) {
+      h_elem2soft(i,j) = elem2soft[i][j];
+      h_softflag(i,j) = softflag[i][j];
+      h_cutshortsq(i,j) = cutshortsq[i][j];
+      for (int k = 0; k < nelements; k++)
+        h_elem2param(i,j,k) = elem2param[i][j][k];
+    }
+
+  for (int m = 0; m < nparams; m++)
+    h_params[m] = params[m];
+
+  for (int m = 0; m < nsofts; m++)
+    h_soft[m] = soft[m];
+
+  k_elem2param.template modify<LMPHostType>();
+  k_elem2param.template sync<DeviceType>();
+  k_elem2soft.template modify<LMPHostType>();
+  k_elem2soft.template sync<DeviceType>();
+  k_softflag.template modify<LMPHostType>();
+  k_softflag.template sync<DeviceType>();
+  k_cutshortsq.template modify<LMPHostType>();
+  k_cutshortsq.template sync<DeviceType>();
+  k_params.template modify<LMPHostType>();
+  k_params.template sync<DeviceType>();
+  k_soft.template modify<LMPHostType>();
+  k_soft.template sync<DeviceType>();
+
+  d_elem2param = k_elem2param.template view<DeviceType>();
+  d_elem2soft = k_elem2soft.template view<DeviceType>();
+  d_softflag = k_softflag.template view<DeviceType>();
+  d_cutshortsq = k_cutshortsq.template view<DeviceType>();
+  d_params = k_params.template view<DeviceType>();
+  d_soft = k_soft.template view<DeviceType>();
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::twobody(const Param& param, const F_FLOAT& rsq, F_FLOAT& fforce,
+                                          const int& eflag, F_FLOAT& eng) const
+{
+  F_FLOAT r,rinvsq,rp,rq,rainv,rainvsq,expsrainv;
+
+  r = sqrt(rsq);
+  rinvsq = 1.0/rsq;
+  rp = pow(r,-param.powerp);
+  rq = pow(r,-param.powerq);
+  rainv = 1.0 / (r - param.cutpair);
+  rainvsq = rainv*rainv*r;
+  expsrainv = exp(param.sigma * rainv);
+  fforce = (param.c1*rp - param.c2*rq +
+            (param.c3*rp -param.c4*rq) * rainvsq) * expsrainv * rinvsq;
+  if (eflag) eng = (param.c5*rp - param.c6*rq) * expsrainv;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::threebody(const Param& paramijk,
+                                            const F_FLOAT& rsq1, const F_FLOAT& rsq2,
+                                            F_FLOAT *delr1, F_FLOAT *delr2,
+                                            F_FLOAT *fj, F_FLOAT *fk, const int& eflag, F_FLOAT& eng) const
+{
+  F_FLOAT r1,rinvsq1,rainv1,gsrainv1,expgsrainv1,dexpgsrainv1;
+  F_FLOAT r2,rinvsq2,rainv2,gsrainv2,expgsrainv2,dexpgsrainv2;
+  F_FLOAT rinv12,cs,delcs,delcssq,facexp,facrad,frad1,frad2;
+  F_FLOAT facang,facang12,csfacang,csfac1,csfac2;
+
+  r1 = sqrt(rsq1);
+  rinvsq1 = 1.0/rsq1;
+  rainv1 = 1.0/(r1 - paramijk.cutij);
+  gsrainv1 = paramijk.sigma_gammaij * rainv1;
+  expgsrainv1 = exp(gsrainv1);
+  dexpgsrainv1 = expgsrainv1 * gsrainv1 * rainv1 / r1;
+
+  r2 = sqrt(rsq2);
+  rinvsq2 = 1.0/rsq2;
+  rainv2 = 1.0/(r2 - paramijk.cutik);
+  gsrainv2 = paramijk.sigma_gammaik * rainv2;
+  expgsrainv2 = exp(gsrainv2);
+  dexpgsrainv2 = expgsrainv2 * gsrainv2 * rainv2 / r2;
+
+  rinv12 = 1.0/(r1*r2);
+  cs = (delr1[0]*delr2[0] + delr1[1]*delr2[1] + delr1[2]*delr2[2]) * rinv12;
+  delcs = cs - paramijk.costheta;
+  delcssq = delcs * delcs * (1.0 + paramijk.alpha * delcs);
+
+  facexp = expgsrainv1*expgsrainv2;
+
+  facrad = paramijk.lambda_epsilon * facexp * delcssq;
+  frad1 = paramijk.lambda_epsilon * delcssq * dexpgsrainv1 * expgsrainv2;
+  frad2 = paramijk.lambda_epsilon * delcssq * expgsrainv1 * dexpgsrainv2;
+  facang = paramijk.lambda_epsilon * facexp * delcs * (2.0 + 3.0 * paramijk.alpha * delcs);
+  facang12 = rinv12*facang;
+  csfacang = cs*facang;
+  csfac1 = rinvsq1*csfacang;
+
+  fj[0] = delr1[0]*(frad1+csfac1)-delr2[0]*facang12;
+  fj[1] = delr1[1]*(frad1+csfac1)-delr2[1]*facang12;
+  fj[2] = delr1[2]*(frad1+csfac1)-delr2[2]*facang12;
+
+  csfac2 = rinvsq2*csfacang;
+
+  fk[0] = delr2[0]*(frad2+csfac2)-delr1[0]*facang12;
+  fk[1] = delr2[1]*(frad2+csfac2)-delr1[1]*facang12;
+  fk[2] = delr2[2]*(frad2+csfac2)-delr1[2]*facang12;
+
+  if (eflag) eng = facrad;
+}
+
+/* ----------------------------------------------------------------------
+   softening function g(Z) and dg/dZ, same as PairSWWOO::gsoft/dgsoft
+------------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+F_FLOAT PairSWWOOKokkos<DeviceType>::gsoft(const Softparam& sp, const F_FLOAT& cn) const
+{
+  const F_FLOAT first = sp.ma / (exp((sp.mb - cn) / sp.mc) + 1.0);
+  const F_FLOAT second = exp(sp.md * (cn - sp.me) * (cn - sp.me));
+  return first * second;
+}
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+F_FLOAT PairSWWOOKokkos<DeviceType>::dgsoft(const Softparam& sp, const F_FLOAT& cn) const
+{
+  const F_FLOAT first = sp.ma / (exp((sp.mb - cn) / sp.mc) + 1.0);
+  const F_FLOAT second = exp(sp.md * (cn - sp.me) * (cn - sp.me));
+  const F_FLOAT third = 2.0 * sp.md * (cn - sp.me) +
+    1.0 / sp.mc / (1.0 + exp((cn - sp.mb) / sp.mc));
+  return first * second * third;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int NEIGHFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::ev_tally(EV_FLOAT &ev, const int &i, const int &j,
+      const F_FLOAT &epair, const F_FLOAT &fpair, const F_FLOAT &delx,
+                const F_FLOAT &dely, const F_FLOAT &delz) const
+{
+  const int VFLAG = vflag_either;
+
+  // The eatom and vatom arrays are atomic for Half/Thread neighbor style
+  Kokkos::View<E_FLOAT*, typename DAT::t_efloat_1d::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<NEIGHFLAG>::value> > v_eatom = k_eatom.view<DeviceType>();
+  Kokkos::View<F_FLOAT*[6], typename DAT::t_virial_array::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<NEIGHFLAG>::value> > v_vatom = k_vatom.view<DeviceType>();
+
+  if (eflag_atom) {
+    const E_FLOAT epairhalf = 0.5 * epair;
+    v_eatom[i] += epairhalf;
+    if (NEIGHFLAG != FULL) v_eatom[j] += epairhalf;
+  }
+
+  if (VFLAG) {
+    const E_FLOAT v0 = delx*delx*fpair;
+    const E_FLOAT v1 = dely*dely*fpair;
+    const E_FLOAT v2 = delz*delz*fpair;
+    const E_FLOAT v3 = delx*dely*fpair;
+    const E_FLOAT v4 = delx*delz*fpair;
+    const E_FLOAT v5 = dely*delz*fpair;
+
+    if (vflag_global) {
+      if (NEIGHFLAG != FULL) {
+        ev.v[0] += v0;
+        ev.v[1] += v1;
+        ev.v[2] += v2;
+        ev.v[3] += v3;
+        ev.v[4] += v4;
+        ev.v[5] += v5;
+      } else {
+        ev.v[0] += 0.5*v0;
+        ev.v[1] += 0.5*v1;
+        ev.v[2] += 0.5*v2;
+        ev.v[3] += 0.5*v3;
+        ev.v[4] += 0.5*v4;
+        ev.v[5] += 0.5*v5;
+      }
+    }
+
+    if (vflag_atom) {
+      v_vatom(i,0) += 0.5*v0;
+      v_vatom(i,1) += 0.5*v1;
+      v_vatom(i,2) += 0.5*v2;
+      v_vatom(i,3) += 0.5*v3;
+      v_vatom(i,4) += 0.5*v4;
+      v_vatom(i,5) += 0.5*v5;
+
+      if (NEIGHFLAG != FULL) {
+        v_vatom(j,0) += 0.5*v0;
+        v_vatom(j,1) += 0.5*v1;
+        v_vatom(j,2) += 0.5*v2;
+        v_vatom(j,3) += 0.5*v3;
+        v_vatom(j,4) += 0.5*v4;
+        v_vatom(j,5) += 0.5*v5;
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   tally eng_vdwl and virial into global and per-atom accumulators
+   called by SW and hbond potentials, newton_pair is always on
+   virial = riFi + rjFj + rkFk = (rj-ri) Fj + (rk-ri) Fk = drji*fj + drki*fk
+ ------------------------------------------------------------------------- */
+
+template<class DeviceType>
+template<int NEIGHFLAG>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::ev_tally3(EV_FLOAT &ev, const int &i, const int &j, int &k,
+          const F_FLOAT &evdwl, const F_FLOAT &ecoul,
+                     F_FLOAT *fj, F_FLOAT *fk, F_FLOAT *drji, F_FLOAT *drki) const
+{
+  F_FLOAT epairthird,v[6];
+
+  const int VFLAG = vflag_either;
+
+  // The eatom and vatom arrays are atomic for Half/Thread neighbor style
+  Kokkos::View<E_FLOAT*, typename DAT::t_efloat_1d::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<NEIGHFLAG>::value> > v_eatom = k_eatom.view<DeviceType>();
+  Kokkos::View<F_FLOAT*[6], typename DAT::t_virial_array::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<NEIGHFLAG>::value> > v_vatom = k_vatom.view<DeviceType>();
+
+  if (eflag_atom) {
+    epairthird = THIRD * (evdwl + ecoul);
+    v_eatom[i] += epairthird;
+    if (NEIGHFLAG != FULL) {
+      v_eatom[j] += epairthird;
+      v_eatom[k] += epairthird;
+    }
+  }
+
+  if (VFLAG) {
+    v[0] = drji[0]*fj[0] + drki[0]*fk[0];
+    v[1] = drji[1]*fj[1] + drki[1]*fk[1];
+    v[2] = drji[2]*fj[2] + drki[2]*fk[2];
+    v[3] = drji[0]*fj[1] + drki[0]*fk[1];
+    v[4] = drji[0]*fj[2] + drki[0]*fk[2];
+    v[5] = drji[1]*fj[2] + drki[1]*fk[2];
+
+    if (vflag_global) {
+      ev.v[0] += v[0];
+      ev.v[1] += v[1];
+      ev.v[2] += v[2];
+      ev.v[3] += v[3];
+      ev.v[4] += v[4];
+      ev.v[5] += v[5];
+    }
+
+    if (vflag_atom) {
+      v_vatom(i,0) += THIRD*v[0];
+      v_vatom(i,1) += THIRD*v[1];
+      v_vatom(i,2) += THIRD*v[2];
+      v_vatom(i,3) += THIRD*v[3];
+      v_vatom(i,4) += THIRD*v[4];
+      v_vatom(i,5) += THIRD*v[5];
+
+      if (NEIGHFLAG != FULL) {
+        v_vatom(j,0) += THIRD*v[0];
+        v_vatom(j,1) += THIRD*v[1];
+        v_vatom(j,2) += THIRD*v[2];
+        v_vatom(j,3) += THIRD*v[3];
+        v_vatom(j,4) += THIRD*v[4];
+        v_vatom(j,5) += THIRD*v[5];
+
+        v_vatom(k,0) += THIRD*v[0];
+        v_vatom(k,1) += THIRD*v[1];
+        v_vatom(k,2) += THIRD*v[2];
+        v_vatom(k,3) += THIRD*v[3];
+        v_vatom(k,4) += THIRD*v[4];
+        v_vatom(k,5) += THIRD*v[5];
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   tally the per-atom third of a three-body term to leg atom i only,
+   used by the full neighbor option for triplets centered on a neighbor
+   virial = drji*fj + drki*fk relative to the central atom
+ ------------------------------------------------------------------------- */
+
+template<class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void PairSWWOOKokkos<DeviceType>::ev_tally3_atom(const int &i,
+          const F_FLOAT &evdwl, const F_FLOAT &ecoul,
+                     F_FLOAT *fj, F_FLOAT *fk, F_FLOAT *drji, F_FLOAT *drki) const
+{
+  F_FLOAT v[6];
+
+  // only atom i is written, no atomics are needed
+  Kokkos::View<E_FLOAT*, typename DAT::t_efloat_1d::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<FULL>::value> > v_eatom = k_eatom.view<DeviceType>();
+  Kokkos::View<F_FLOAT*[6], typename DAT::t_virial_array::array_layout,DeviceType,Kokkos::MemoryTraits<AtomicF<FULL>::value> > v_vatom = k_vatom.view<DeviceType>();
+
+  if (eflag_atom) v_eatom[i] += THIRD * (evdwl + ecoul);
+
+  if (vflag_atom) {
+    v[0] = drji[0]*fj[0] + drki[0]*fk[0];
+    v[1] = drji[1]*fj[1] + drki[1]*fk[1];
+    v[2] = drji[2]*fj[2] + drki[2]*fk[2];
+    v[3] = drji[0]*fj[1] + drki[0]*fk[1];
+    v[4] = drji[0]*fj[2] + drki[0]*fk[2];
+    v[5] = drji[1]*fj[2] + drki[1]*fk[2];
+
+    v_vatom(i,0) += THIRD*v[0];
+    v_vatom(i,1) += THIRD*v[1];
+    v_vatom(i,2) += THIRD*v[2];
+    v_vatom(i,3) += THIRD*v[3];
+    v_vatom(i,4) += THIRD*v[4];
+    v_vatom(i,5) += THIRD*v[5];
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+template<class DeviceType>
+double PairSWWOOKokkos<DeviceType>::memory_usage()
+{
+  double bytes = PairSWWOO::memory_usage();
+  bytes += d_neighbors_short.dimension_0() * d_neighbors_short.dimension_1() * sizeof(int);
+  bytes += d_numneigh_short.dimension_0() * sizeof(int);
+  return bytes;
+}
+
+namespace LAMMPS_NS {
+template class PairSWWOOKokkos<LMPDeviceType>;
+#ifdef KOKKOS_HAVE_CUDA
+template class PairSWWOOKokkos<LMPHostType>;
+#endif
+}
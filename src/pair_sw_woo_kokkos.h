@@ -0,0 +1,233 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------------
+   Kokkos version of the modified Stillinger-Weber potential (sw/woo)
+   Modified from the Kokkos Stillinger-Weber style by: Stan Moore (SNL)
+------------------------------------------------------------------------- */
+
+#ifdef PAIR_CLASS
+
+PairStyle(sw/woo/kk,PairSWWOOKokkos<LMPDeviceType>)
+PairStyle(sw/woo/kk/device,PairSWWOOKokkos<LMPDeviceType>)
+PairStyle(sw/woo/kk/host,PairSWWOOKokkos<LMPHostType>)
+
+#else
+
+#ifndef LMP_PAIR_SW_WOO_KOKKOS_H
+#define LMP_PAIR_SW_WOO_KOKKOS_H
+
+#include "pair_sw_woo.h"
+#include "pair_kokkos.h"
+
+struct TagPairSWWOOComputeShortNeigh{};
+struct TagPairSWWOOComputeCoord{};
+
+template<int NEIGHFLAG, int EVFLAG>
+struct TagPairSWWOOComputeHalf{};
+
+template<int NEIGHFLAG, int EVFLAG>
+struct TagPairSWWOOComputeFullA{};
+
+template<int NEIGHFLAG, int EVFLAG>
+struct TagPairSWWOOComputeFullB{};
+
+template<int NEIGHFLAG, int EVFLAG>
+struct TagPairSWWOOComputeSoft{};
+
+namespace LAMMPS_NS {
+
+template<class DeviceType>
+class PairSWWOOKokkos : public PairSWWOO {
+ public:
+  enum {EnabledNeighFlags=FULL|HALF|HALFTHREAD};
+  enum {COUL_FLAG=0};
+  typedef DeviceType device_type;
+  typedef ArrayTypes<DeviceType> AT;
+  typedef EV_FLOAT value_type;
+
+  PairSWWOOKokkos(class LAMMPS *);
+  virtual ~PairSWWOOKokkos();
+  virtual void compute(int, int);
+  virtual void coeff(int, char **);
+  virtual void init_style();
+  virtual double init_one(int, int);
+  virtual int pack_forward_comm(int, int *, double *, int, int *);
+  virtual void unpack_forward_comm(int, int, double *);
+  virtual double memory_usage();
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeShortNeigh, const int&) const;
+
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeCoord, const int&) const;
+
+  template<int NEIGHFLAG, int EVFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeHalf<NEIGHFLAG,EVFLAG>, const int&, EV_FLOAT&) const;
+
+  template<int NEIGHFLAG, int EVFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeHalf<NEIGHFLAG,EVFLAG>, const int&) const;
+
+  template<int NEIGHFLAG, int EVFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeFullA<NEIGHFLAG,EVFLAG>, const int&, EV_FLOAT&) const;
+
+  template<int NEIGHFLAG, int EVFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeFullA<NEIGHFLAG,EVFLAG>, const int&) const;
+
+  template<int NEIGHFLAG, int EVFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeFullB<NEIGHFLAG,EVFLAG>, const int&) const;
+
+  template<int NEIGHFLAG, int EVFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeSoft<NEIGHFLAG,EVFLAG>, const int&, EV_FLOAT&) const;
+
+  template<int NEIGHFLAG, int EVFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void operator()(TagPairSWWOOComputeSoft<NEIGHFLAG,EVFLAG>, const int&) const;
+
+  template<int NEIGHFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void ev_tally(EV_FLOAT &ev, const int &i, const int &j,
+                const F_FLOAT &epair, const F_FLOAT &fpair, const F_FLOAT &delx,
+                const F_FLOAT &dely, const F_FLOAT &delz) const;
+
+  template<int NEIGHFLAG>
+  KOKKOS_INLINE_FUNCTION
+  void ev_tally3(EV_FLOAT &ev, const int &i, const int &j, int &k,
+                 const F_FLOAT &evdwl, const F_FLOAT &ecoul,
+                 F_FLOAT *fj, F_FLOAT *fk, F_FLOAT *drji, F_FLOAT *drki) const;
+
+  KOKKOS_INLINE_FUNCTION
+  void ev_tally3_atom(const int &i, const F_FLOAT &evdwl, const F_FLOAT &ecoul,
+                      F_FLOAT *fj, F_FLOAT *fk, F_FLOAT *drji, F_FLOAT *drki) const;
+
+ protected:
+  typedef Kokkos::DualView<int***,DeviceType> tdual_int_3d;
+  typedef typename tdual_int_3d::t_dev_const_randomread t_int_3d_randomread;
+  typedef typename tdual_int_3d::t_host t_host_int_3d;
+
+  t_int_3d_randomread d_elem2param;
+  typename AT::t_int_1d_randomread d_map;
+  typename AT::t_int_2d_randomread d_elem2soft;
+  typename AT::t_int_2d_randomread d_softflag;
+  typename AT::t_ffloat_2d_randomread d_cutshortsq;
+
+  typedef Kokkos::DualView<Param*,DeviceType> tdual_param_1d;
+  typedef typename tdual_param_1d::t_dev t_param_1d;
+  typedef typename tdual_param_1d::t_host t_host_param_1d;
+
+  typedef Kokkos::DualView<Softparam*,DeviceType> tdual_soft_1d;
+  typedef typename tdual_soft_1d::t_dev t_soft_1d;
+  typedef typename tdual_soft_1d::t_host t_host_soft_1d;
+
+  t_param_1d d_params;
+  t_soft_1d d_soft;
+
+  virtual void setup();
+
+  KOKKOS_INLINE_FUNCTION
+  void twobody(const Param&, const F_FLOAT&, F_FLOAT&, const int&, F_FLOAT&) const;
+
+  KOKKOS_INLINE_FUNCTION
+  void threebody(const Param&, const F_FLOAT&, const F_FLOAT&, F_FLOAT *, F_FLOAT *,
+                 F_FLOAT *, F_FLOAT *, const int&, F_FLOAT&) const;
+
+  KOKKOS_INLINE_FUNCTION
+  F_FLOAT gsoft(const Softparam&, const F_FLOAT&) const;
+
+  KOKKOS_INLINE_FUNCTION
+  F_FLOAT dgsoft(const Softparam&, const F_FLOAT&) const;
+
+  typename ArrayTypes<DeviceType>::t_x_array_randomread x;
+  typename ArrayTypes<DeviceType>::t_f_array f;
+  typename ArrayTypes<DeviceType>::t_tagint_1d tag;
+  typename ArrayTypes<DeviceType>::t_int_1d_randomread type;
+
+  DAT::tdual_efloat_1d k_eatom;
+  DAT::tdual_virial_array k_vatom;
+  DAT::t_efloat_1d d_eatom;
+  DAT::t_virial_array d_vatom;
+
+  DAT::tdual_ffloat_1d k_coord;
+  DAT::tdual_ffloat_1d k_dedz;
+  typename AT::t_ffloat_1d d_coord;
+  typename AT::t_ffloat_1d d_dedz;
+
+  typename AT::t_neighbors_2d d_neighbors;
+  typename AT::t_int_1d_randomread d_ilist;
+  typename AT::t_int_1d_randomread d_numneigh;
+
+  int neighflag,newton_pair;
+  int nlocal,nall,eflag,vflag;
+  int commflag;            // 1 if forward comm sends dE/dZ instead of Z
+
+  Kokkos::View<int**,DeviceType> d_neighbors_short;
+  Kokkos::View<int*,DeviceType> d_numneigh_short;
+
+  friend void pair_virial_fdotr_compute<PairSWWOOKokkos>(PairSWWOOKokkos*);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Cannot use chosen neighbor list style with pair sw/woo/kk
+
+Only the full, half and half/thread neighbor list options of the
+KOKKOS package are supported. The style always builds a full neighbor
+list internally. With half and half/thread it scatters forces with
+(atomic) updates, with full each atom gathers its own force.
+
+E: Pair style sw/woo/kk with neigh full requires a ghost cutoff of twice the pair cutoff
+
+With the full neighbor option each atom also computes the three-body
+terms centered on its neighbors, which needs the neighbors of ghost
+atoms up to twice the pair cutoff plus the neighbor skin.  Use
+comm_modify cutoff.
+
+E: Pair style sw/woo/kk does not support the table keyword
+
+The Kokkos version always evaluates the radial functions analytically.
+
+E: Pair style sw/woo/kk does not support the precision keyword
+
+The Kokkos version always computes in double precision.
+
+E: Pair style sw/woo/kk does not support the fastmath keyword
+
+The Kokkos version always evaluates the softening cutoff and g(Z)
+analytically.
+
+E: Pair style sw/woo/kk does not support the sort keyword
+
+The Kokkos version keeps the neighbor order of the short lists.
+
+E: Pair style sw/woo/kk does not support the triplets keyword
+
+The Kokkos version evaluates the three-body terms from the short
+neighbor lists of every step and does not cache triplets.
+
+E: Pair style sw/woo/kk does not support the fused keyword
+
+The Kokkos version always computes the coordination numbers in a
+separate kernel before the pair and three-body terms.
+
+*/
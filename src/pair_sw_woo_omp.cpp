@@ -0,0 +1,601 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   This software is distributed under the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------------
+   OpenMP version of the modified Stillinger-Weber potential (sw/woo)
+   Modified from the OpenMP Stillinger-Weber style by: Axel Kohlmeyer
+------------------------------------------------------------------------- */
+
+#include <math.h>
+#include <string.h>
+#include "pair_sw_woo_omp.h"
+#include "atom.h"
+#include "comm.h"
+#include "force.h"
+#include "memory.h"
+#include "neighbor.h"
+#include "neigh_list.h"
+#include "pair_sw_sort.h"
+#include "pair_sw_kernel.h"
+#include "error.h"
+
+#include "suffix.h"
+using namespace LAMMPS_NS;
+using namespace PairSWSort;
+using namespace PairSWKernel;
+
+/* ---------------------------------------------------------------------- */
+
+PairSWWOOOMP::PairSWWOOOMP(LAMMPS *lmp) :
+  PairSWWOO(lmp), ThrOMP(lmp, THR_PAIR)
+{
+  suffix_flag |= Suffix::OMP;
+  respa_enable = 0;
+
+  nthrbound = thrinum = maxthrcost = 0;
+  nthrdedz = 0;
+  thrbound = NULL;
+  thrcost = NULL;
+  nthrshort = 0;
+  maxthrshort = NULL;
+  thrshort = NULL;
+  maxthrsoft = NULL;
+  thrsoftneigh = NULL;
+  thrsoftdfc = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+
+PairSWWOOOMP::~PairSWWOOOMP()
+{
+  memory->destroy(thrbound);
+  memory->destroy(thrcost);
+  destroy_thrshort();
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWOOOMP::init_style()
+{
+  PairSWWOO::init_style();
+  destroy_thrshort();
+
+  if (precision != PREC_DOUBLE)
+    error->all(FLERR,"Pair style sw/woo/omp does not support the precision keyword");
+  if (sortflag != NONE)
+    error->all(FLERR,"Pair style sw/woo/omp does not support the sort keyword");
+  if (tripflag)
+    error->all(FLERR,"Pair style sw/woo/omp does not support the triplets keyword");
+  if (fused)
+    error->all(FLERR,"Pair style sw/woo/omp does not support the fused keyword");
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWOOOMP::compute(int eflag, int vflag)
+{
+  if (eflag || vflag) {
+    ev_setup(eflag,vflag);
+  } else evflag = vflag_fdotr = 0;
+
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int inum = list->inum;
+
+  // grow coordination arrays if necessary
+  // need to be atom->nmax in length, dE/dZ once per thread,
+  // so it is also redone when the number of threads changes
+
+  if (atom->nmax > nmax) {
+    memory->destroy(coord);
+    memory->destroy(gcn);
+    memory->destroy(softfirst);
+    memory->destroy(softnum);
+    nmax = atom->nmax;
+    memory->create(coord,nmax,"pair:coord");
+    memory->create(gcn,nmax,2*nelements,"pair:gcn");
+    memory->create(softfirst,nmax,"pair:softfirst");
+    memory->create(softnum,nmax,"pair:softnum");
+    nthrdedz = 0;
+  }
+
+  if (nthreads != nthrdedz) {
+    memory->destroy(dedz);
+    nthrdedz = nthreads;
+    memory->create(dedz,nthrdedz*nmax,"pair:dedz");
+  }
+
+  // per thread ranges of the atom list with about equal estimated cost,
+  // redone when the neighbor list or the number of threads changes
+
+  const int sched = (schedflag == SCHED_COST) &&
+    (neighbor->ago == 0 || nthrbound != nthreads || thrinum != inum);
+
+  if (sched) {
+    if (inum > maxthrcost) {
+      maxthrcost = inum;
+      memory->destroy(thrcost);
+      memory->create(thrcost,maxthrcost,"pair:thrcost");
+    }
+    if (nthreads != nthrbound) {
+      nthrbound = nthreads;
+      memory->destroy(thrbound);
+      memory->create(thrbound,nthreads+1,"pair:thrbound");
+    }
+    thrinum = inum;
+  }
+
+  // per thread short and soft lists persist across steps,
+  // add slots for new threads
+
+  if (nthreads > nthrshort) {
+    maxthrshort = (int *)
+      memory->srealloc(maxthrshort,nthreads*sizeof(int),"pair:maxthrshort");
+    thrshort = (int **)
+      memory->srealloc(thrshort,nthreads*sizeof(int *),"pair:thrshort");
+    maxthrsoft = (int *)
+      memory->srealloc(maxthrsoft,nthreads*sizeof(int),"pair:maxthrsoft");
+    thrsoftneigh = (int **)
+      memory->srealloc(thrsoftneigh,nthreads*sizeof(int *),"pair:thrsoftneigh");
+    thrsoftdfc = (double **)
+      memory->srealloc(thrsoftdfc,nthreads*sizeof(double *),"pair:thrsoftdfc");
+    for (int t = nthrshort; t < nthreads; t++) {
+      maxthrshort[t] = maxthrsoft[t] = 0;
+      thrshort[t] = thrsoftneigh[t] = NULL;
+      thrsoftdfc[t] = NULL;
+    }
+    nthrshort = nthreads;
+  }
+
+#if defined(_OPENMP)
+#pragma omp parallel default(none) shared(eflag,vflag)
+#endif
+  {
+    int ifrom, ito, tid;
+
+    loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+
+    if (sched) {
+      cost_thr(ifrom, ito);
+      sync_threads();
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+      { cost_partition(inum, thrcost, nthreads, thrbound); }
+      sync_threads();
+    }
+    if (schedflag == SCHED_COST) {
+      ifrom = thrbound[tid];
+      ito = thrbound[tid+1];
+    }
+
+    ThrData *thr = fix->get_thr(tid);
+    thr->timer(Timer::START);
+    ev_setup_thr(eflag, vflag, nall, eatom, vatom, thr);
+
+    // each thread only writes the coordination of its own atoms,
+    // but the pair loop reads those of all atoms, so wait for all threads
+
+    coord_thr(ifrom, ito, maxthrsoft[tid], thrsoftneigh[tid], thrsoftdfc[tid]);
+    sync_threads();
+
+    // communicate coordination numbers and softening of ghost atoms
+    // on the master thread and wait until it is done
+
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+    { comm->forward_comm_pair(this); }
+
+    sync_threads();
+
+    double * const dedz_thr = dedz + tid*nall;
+    memset(dedz_thr,0,nall*sizeof(double));
+
+    if (evflag) {
+      if (eflag) {
+        eval<1,1>(ifrom, ito, dedz_thr, thr);
+      } else {
+        eval<1,0>(ifrom, ito, dedz_thr, thr);
+      }
+    } else eval<0,0>(ifrom, ito, dedz_thr, thr);
+
+    // sum per thread dE/dZ, then the ghost atom contributions on the
+    // master thread, and wait until it is done
+
+    data_reduce_thr(dedz, nall, nthreads, 1, tid);
+    sync_threads();
+
+#if defined(_OPENMP)
+#pragma omp master
+#endif
+    { comm->reverse_comm_pair(this); }
+
+    sync_threads();
+
+    if (evflag) dsoft_thr<1>(ifrom, ito, thrsoftneigh[tid], thrsoftdfc[tid], thr);
+    else dsoft_thr<0>(ifrom, ito, thrsoftneigh[tid], thrsoftdfc[tid], thr);
+
+    thr->timer(Timer::PAIR);
+    reduce_thr(this, eflag, vflag, thr);
+  } // end of omp parallel region
+}
+
+/* ----------------------------------------------------------------------
+   estimated cost of atom list entries ifrom to ito-1
+------------------------------------------------------------------------- */
+
+void PairSWWOOOMP::cost_thr(int iifrom, int iito)
+{
+  int i,j,ii,jj,jnum,itype,jtype,nshort;
+  double delx,dely,delz,rsq;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  const int * _noalias const type = atom->type;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  for (ii = iifrom; ii < iito; ++ii) {
+    i = ilist[ii];
+    itype = map[type[i]];
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+    nshort = 0;
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      j &= NEIGHMASK;
+      delx = x[i].x - x[j].x;
+      dely = x[i].y - x[j].y;
+      delz = x[i].z - x[j].z;
+      rsq = delx*delx + dely*dely + delz*delz;
+      jtype = map[type[j]];
+      if (rsq < cutshortsq[itype][jtype]) nshort++;
+    }
+    thrcost[ii] = atom_cost(jnum,nshort);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   make the short list of thread tid hold at least n neighbors, rounded
+   up to whole cache lines so lists of different threads share none.
+   called by that thread only, before the list is filled
+------------------------------------------------------------------------- */
+
+void PairSWWOOOMP::grow_thrshort(int tid, int n)
+{
+  n = (n + 15) & ~15;
+  memory->destroy(thrshort[tid]);
+  memory->create(thrshort[tid],n,"pair:thrshort");
+  maxthrshort[tid] = n;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairSWWOOOMP::destroy_thrshort()
+{
+  for (int t = 0; t < nthrshort; t++) {
+    memory->destroy(thrshort[t]);
+    memory->destroy(thrsoftneigh[t]);
+    memory->destroy(thrsoftdfc[t]);
+  }
+  memory->sfree(maxthrshort);
+  memory->sfree(thrshort);
+  memory->sfree(maxthrsoft);
+  memory->sfree(thrsoftneigh);
+  memory->sfree(thrsoftdfc);
+  nthrshort = 0;
+  maxthrshort = maxthrsoft = NULL;
+  thrshort = thrsoftneigh = NULL;
+  thrsoftdfc = NULL;
+}
+
+/* ----------------------------------------------------------------------
+   coordination number for softening function of atoms ifrom to ito-1
+   transition zone neighbors and dfc/(sigma*r) go to per thread arrays
+------------------------------------------------------------------------- */
+
+void PairSWWOOOMP::coord_thr(int iifrom, int iito, int &maxsoft_thr,
+                             int *&softneigh_thr, double *&softdfc_thr)
+{
+  int i,j,ii,jj,jnum,itype,jtype,ijparam,nsoft;
+  double xtmp,ytmp,ztmp,delx,dely,delz,rsq,r,rs,bigr,bigd,dfc,ctmp;
+  int *ilist,*jlist,*numneigh,**firstneigh;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  const int * _noalias const type = atom->type;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+
+  nsoft = 0;
+  for (ii = iifrom; ii < iito; ++ii) {
+    i = ilist[ii];
+    itype = map[type[i]];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    ctmp = 0.0;
+
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+
+    if (nsoft + jnum > maxsoft_thr) {
+      maxsoft_thr = nsoft + jnum + maxsoft_thr/2;
+      memory->grow(softneigh_thr,maxsoft_thr,"pair:softneigh_thr");
+      memory->grow(softdfc_thr,maxsoft_thr,"pair:softdfc_thr");
+    }
+    softfirst[i] = nsoft;
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      j &= NEIGHMASK;
+      jtype = map[type[j]];
+
+      if (softflag[itype][jtype]) {
+        ijparam = elem2param[itype][jtype][jtype];
+        bigr = soft[elem2soft[itype][jtype]].bigr;
+        bigd = soft[elem2soft[itype][jtype]].bigd;
+        delx = xtmp - x[j].x;
+        dely = ytmp - x[j].y;
+        delz = ztmp - x[j].z;
+        rsq = delx*delx + dely*dely + delz*delz;
+        rs = sqrt(rsq);
+        r = rs / params[ijparam].sigma;
+
+        if (r < (bigr - bigd)) ctmp += 1;
+        else if (r < (bigr + bigd)) {
+          ctmp += soft_cut(r-bigr+bigd, pairparam[itype*nelements+jtype], dfc);
+          softneigh_thr[nsoft] = j;
+          softdfc_thr[nsoft++] = dfc / (params[ijparam].sigma * rs);
+        }
+      }
+    }
+    coord[i] = ctmp;
+    softnum[i] = nsoft - softfirst[i];
+    soften(i,itype);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <int EVFLAG, int EFLAG>
+void PairSWWOOOMP::eval(int iifrom, int iito, double * const dedz_thr,
+                        ThrData * const thr)
+{
+  int i,j,k,ii,jj,kk,jnum,jnumm1;
+  tagint itag,jtag;
+  int itype,jtype,ktype,ijparam,ijkparam;
+  double xtmp,ytmp,ztmp,delx,dely,delz,evdwl,fpair;
+  double rsq,rsq1,rsq2,gij;
+  double delr1[3],delr2[3],fj[3],fk[3];
+  int *ilist,*jlist,*numneigh,**firstneigh,*neighshort_thr;
+
+  evdwl = 0.0;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  dbl3_t * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  const tagint * _noalias const tag = atom->tag;
+  const int * _noalias const type = atom->type;
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+  numneigh = list->numneigh;
+  firstneigh = list->firstneigh;
+  const int tid = thr->get_tid();
+  neighshort_thr = thrshort[tid];
+
+  double fxtmp,fytmp,fztmp;
+
+  // loop over full neighbor list of my atoms
+
+  for (ii = iifrom; ii < iito; ++ii) {
+
+    i = ilist[ii];
+    itag = tag[i];
+    itype = map[type[i]];
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    fxtmp = fytmp = fztmp = 0.0;
+
+    // two-body interactions, skip half of them
+
+    jlist = firstneigh[i];
+    jnum = numneigh[i];
+    int numshort = 0;
+    if (jnum > maxthrshort[tid]) {
+      grow_thrshort(tid,jnum);
+      neighshort_thr = thrshort[tid];
+    }
+
+    for (jj = 0; jj < jnum; jj++) {
+      j = jlist[jj];
+      j &= NEIGHMASK;
+      jtype = map[type[j]];
+
+      delx = xtmp - x[j].x;
+      dely = ytmp - x[j].y;
+      delz = ztmp - x[j].z;
+      rsq = delx*delx + dely*dely + delz*delz;
+
+      if (rsq < cutshortsq[itype][jtype]) {
+        neighshort_thr[numshort++] = j;
+      }
+
+      jtag = tag[j];
+      if (itag > jtag) {
+        if ((itag+jtag) % 2 == 0) continue;
+      } else if (itag < jtag) {
+        if ((itag+jtag) % 2 == 1) continue;
+      } else {
+        if (x[j].z < ztmp) continue;
+        if (x[j].z == ztmp && x[j].y < ytmp) continue;
+        if (x[j].z == ztmp && x[j].y == ytmp && x[j].x < xtmp) continue;
+      }
+
+      ijparam = elem2param[itype][jtype][jtype];
+      if (rsq > params[ijparam].cutpairsq) continue;
+
+      // softened pairs always need the bare pair energy,
+      // it enters dE/dZ of the atom whose coordination softens the bond
+
+      if (softflag[itype][jtype]) {
+        twobody(&params[ijparam],rsq,fpair,1,evdwl);
+        gij = gcn[i][2*jtype];
+        dedz_thr[i] += gcn[i][2*jtype+1] * evdwl;
+      } else if (softflag[jtype][itype]) {
+        twobody(&params[ijparam],rsq,fpair,1,evdwl);
+        gij = gcn[j][2*itype];
+        dedz_thr[j] += gcn[j][2*itype+1] * evdwl;
+      } else {
+        twobody(&params[ijparam],rsq,fpair,EFLAG,evdwl);
+        gij = 1;
+      }
+
+      evdwl = gij * evdwl;
+      fpair = gij * fpair;
+
+      fxtmp += delx*fpair;
+      fytmp += dely*fpair;
+      fztmp += delz*fpair;
+      f[j].x -= delx*fpair;
+      f[j].y -= dely*fpair;
+      f[j].z -= delz*fpair;
+
+      if (EVFLAG) ev_tally_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                               evdwl,0.0,fpair,delx,dely,delz,thr);
+    }
+
+    jnumm1 = numshort - 1;
+
+    for (jj = 0; jj < jnumm1; jj++) {
+      j = neighshort_thr[jj];
+      jtype = map[type[j]];
+      delr1[0] = x[j].x - xtmp;
+      delr1[1] = x[j].y - ytmp;
+      delr1[2] = x[j].z - ztmp;
+      rsq1 = delr1[0]*delr1[0] + delr1[1]*delr1[1] + delr1[2]*delr1[2];
+
+      double fjxtmp,fjytmp,fjztmp;
+      fjxtmp = fjytmp = fjztmp = 0.0;
+
+      for (kk = jj+1; kk < numshort; kk++) {
+        k = neighshort_thr[kk];
+        ktype = map[type[k]];
+        ijkparam = elem2param[itype][jtype][ktype];
+
+        if (rsq1 > params[ijkparam].cutijsq) continue;
+
+        delr2[0] = x[k].x - xtmp;
+        delr2[1] = x[k].y - ytmp;
+        delr2[2] = x[k].z - ztmp;
+        rsq2 = delr2[0]*delr2[0] + delr2[1]*delr2[1] + delr2[2]*delr2[2];
+
+        if (rsq2 > params[ijkparam].cutiksq) continue;
+
+        threebody(&params[ijkparam],rsq1,rsq2,delr1,delr2,fj,fk,EFLAG,evdwl);
+
+        fxtmp -= fj[0] + fk[0];
+        fytmp -= fj[1] + fk[1];
+        fztmp -= fj[2] + fk[2];
+        fjxtmp += fj[0];
+        fjytmp += fj[1];
+        fjztmp += fj[2];
+        f[k].x += fk[0];
+        f[k].y += fk[1];
+        f[k].z += fk[2];
+
+        if (EVFLAG) ev_tally3_thr(this,i,j,k,evdwl,0.0,fj,fk,delr1,delr2,thr);
+      }
+      f[j].x += fjxtmp;
+      f[j].y += fjytmp;
+      f[j].z += fjztmp;
+    }
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   force from the coordination dependence of the softening function
+   for atoms ifrom to ito-1, using the neighbors cached by coord_thr()
+------------------------------------------------------------------------- */
+
+template <int EVFLAG>
+void PairSWWOOOMP::dsoft_thr(int iifrom, int iito, const int * const softneigh_thr,
+                             const double * const softdfc_thr, ThrData * const thr)
+{
+  int i,j,ii,jj,jend;
+  double xtmp,ytmp,ztmp,delx,dely,delz,fpair,dedzi;
+  int *ilist;
+
+  const dbl3_t * _noalias const x = (dbl3_t *) atom->x[0];
+  dbl3_t * _noalias const f = (dbl3_t *) thr->get_f()[0];
+  const int nlocal = atom->nlocal;
+
+  ilist = list->ilist;
+
+  double fxtmp,fytmp,fztmp;
+
+  for (ii = iifrom; ii < iito; ++ii) {
+    i = ilist[ii];
+    dedzi = dedz[i];
+    if (dedzi == 0.0) continue;
+    xtmp = x[i].x;
+    ytmp = x[i].y;
+    ztmp = x[i].z;
+    fxtmp = fytmp = fztmp = 0.0;
+
+    jend = softfirst[i] + softnum[i];
+    for (jj = softfirst[i]; jj < jend; jj++) {
+      j = softneigh_thr[jj];
+      delx = xtmp - x[j].x;
+      dely = ytmp - x[j].y;
+      delz = ztmp - x[j].z;
+      fpair = - dedzi * softdfc_thr[jj];
+
+      fxtmp += delx*fpair;
+      fytmp += dely*fpair;
+      fztmp += delz*fpair;
+      f[j].x -= delx*fpair;
+      f[j].y -= dely*fpair;
+      f[j].z -= delz*fpair;
+
+      if (EVFLAG) ev_tally_thr(this,i,j,nlocal,/* newton_pair */ 1,
+                               0.0,0.0,fpair,delx,dely,delz,thr);
+    }
+    f[i].x += fxtmp;
+    f[i].y += fytmp;
+    f[i].z += fztmp;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairSWWOOOMP::memory_usage()
+{
+  double bytes = memory_usage_thr();
+  bytes += PairSWWOO::memory_usage();
+  bytes += maxthrcost * sizeof(double);
+  bytes += nthrbound * sizeof(int);
+  for (int t = 0; t < nthrshort; t++) {
+    bytes += maxthrshort[t] * sizeof(int);
+    bytes += maxthrsoft[t] * (sizeof(int) + sizeof(double));
+  }
+  if (nthrdedz > 1) bytes += (nthrdedz - 1) * nmax * sizeof(double);
+
+  return bytes;
+}
@@ -0,0 +1,92 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------------
+   OpenMP version of the modified Stillinger-Weber potential (sw/woo)
+   Modified from the OpenMP Stillinger-Weber style by: Axel Kohlmeyer
+------------------------------------------------------------------------- */
+
+#ifdef PAIR_CLASS
+
+PairStyle(sw/woo/omp,PairSWWOOOMP)
+
+#else
+
+#ifndef LMP_PAIR_SW_WOO_OMP_H
+#define LMP_PAIR_SW_WOO_OMP_H
+
+#include "pair_sw_woo.h"
+#include "thr_omp.h"
+
+namespace LAMMPS_NS {
+
+class PairSWWOOOMP : public PairSWWOO, public ThrOMP {
+
+ public:
+  PairSWWOOOMP(class LAMMPS *);
+  virtual ~PairSWWOOOMP();
+
+  virtual void compute(int, int);
+  virtual void init_style();
+  virtual double memory_usage();
+
+ private:
+  int nthrbound;                // # of threads the ranges are made for
+  int thrinum;                  // # of atoms the ranges are made for
+  int *thrbound;                // first atom list entry of each thread
+  int maxthrcost;               // size of thrcost
+  double *thrcost;              // estimated cost of each atom list entry
+  int nthrdedz;                 // # of threads dedz is made for
+  int nthrshort;                // # of threads with a short list
+  int *maxthrshort;             // size of the short list of each thread
+  int **thrshort;               // short neighbor list of each thread
+  int *maxthrsoft;              // size of the soft lists of each thread
+  int **thrsoftneigh;           // transition zone neighbors of each thread
+  double **thrsoftdfc;          // and their dfc/(sigma*r)
+
+  void cost_thr(int ifrom, int ito);
+  void grow_thrshort(int tid, int n);
+  void destroy_thrshort();
+
+  void coord_thr(int ifrom, int ito, int &, int *&, double *&);
+
+  template <int EVFLAG, int EFLAG>
+  void eval(int ifrom, int ito, double * const dedz_thr, ThrData * const thr);
+
+  template <int EVFLAG>
+  void dsoft_thr(int ifrom, int ito, const int * const,
+                 const double * const, ThrData * const thr);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Pair style sw/woo/omp does not support the sort keyword
+
+The threaded kernels keep the neighbor order of the short lists.
+
+E: Pair style sw/woo/omp does not support the triplets keyword
+
+The threaded kernels evaluate the three-body terms from the short
+neighbor lists of every step and do not cache triplets.
+
+E: Pair style sw/woo/omp does not support the fused keyword
+
+The threaded kernels always compute the coordination numbers in a
+separate pass before the pair and three-body terms.
+
+*/